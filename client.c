@@ -1,43 +1,306 @@
 #include "network_app.h"
 
-int connect_to_server(client_connection_meta_t *conn) {
-    struct sockaddr_in server_addr;
+// Create a nonblocking socket and start connect() to the connection's port.
+// *connected is set if the connect completed at once (Unix sockets).
+static int open_client_socket(client_connection_meta_t *conn, int *connected) {
+    struct sockaddr_storage server_addr;
+    socklen_t server_len;
     
-    conn->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (conn->socket_fd == -1) {
+    int fd = transport_create_socket(SOCK_STREAM);
+    if (fd == -1) {
         printf("CLIENT: socket() failed for connection %d: %s\n", 
                conn->thread_index, strerror(errno));
         exit(1);
     }
     
-    if (set_socket_nonblocking(conn->socket_fd) == -1) {
+    if (set_socket_nonblocking(fd) == -1) {
         printf("CLIENT: Failed to set socket non-blocking for connection %d\n", conn->thread_index);
         exit(1);
     }
+    tuning_apply(fd, TUNING_ROLE_CLIENT);
     
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = inet_addr(g_ctx.listen_ip);
-    server_addr.sin_port = htons(conn->port);
+    if (transport_build_address(conn->port, &server_addr, &server_len) == -1) {
+        printf("CLIENT: Invalid connect address '%s' for connection %d\n", 
+               g_ctx.listen_ip, conn->thread_index);
+        exit(1);
+    }
     
-    int result = connect(conn->socket_fd, (struct sockaddr *)&server_addr, sizeof(server_addr));
+    int result = connect(fd, (struct sockaddr *)&server_addr, server_len);
     if (result == -1 && errno != EINPROGRESS) {
-        printf("CLIENT: connect() failed for connection %d to %s:%d: %s\n", 
-               conn->thread_index, g_ctx.listen_ip, conn->port, strerror(errno));
+        char endpoint[MAX_ADDRESS_LEN + 16];
+        transport_format_endpoint(conn->port, endpoint, sizeof(endpoint));
+        printf("CLIENT: connect() failed for connection %d to %s: %s\n", 
+               conn->thread_index, endpoint, strerror(errno));
         exit(1);
     }
+    tuning_report(fd, TUNING_ROLE_CLIENT);
+    
+    *connected = (result == 0) ? 1 : 0;
+    return fd;
+}
+
+// Spare pool (--pool): each connection keeps a ring of sockets whose
+// connect() was started ahead of time, so a reconnect takes a warm socket
+// instead of paying for socket()/connect() and the handshake round trip on
+// the measured path. Spares are not in epoll; the oldest one is taken first
+// and a spare still connecting is finished by the event loop like any other
+// nonblocking connect.
+static int pool_take(client_connection_meta_t *conn, int *connected) {
+    if (conn->pool_count == 0) {
+        return -1;
+    }
+    int fd = conn->pool_fds[conn->pool_head];
+    conn->pool_head = (conn->pool_head + 1) % g_ctx.pool_size;
+    conn->pool_count--;
     
-    conn->is_connected = (result == 0) ? 1 : 0;
+    struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+    *connected = poll(&pfd, 1, 0) == 1 && pfd.revents == POLLOUT;
+    return fd;
+}
+
+static void pool_add_spare(client_connection_meta_t *conn) {
+    int connected;
+    int fd = open_client_socket(conn, &connected);
+    conn->pool_fds[(conn->pool_head + conn->pool_count) % g_ctx.pool_size] = fd;
+    conn->pool_count++;
+}
+
+// Replace the spares taken since the last pass, outside the per-event path
+static void pool_top_up(void) {
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        client_connection_meta_t *conn = &g_ctx.client_connections[i];
+        while (conn->pool_count < g_ctx.pool_size) {
+            pool_add_spare(conn);
+        }
+    }
+}
+
+static void pool_close(client_connection_meta_t *conn) {
+    while (conn->pool_count > 0) {
+        close(conn->pool_fds[conn->pool_head]);
+        conn->pool_head = (conn->pool_head + 1) % g_ctx.pool_size;
+        conn->pool_count--;
+    }
+}
+
+int connect_to_server(client_connection_meta_t *conn) {
+    int connected;
+    
+    conn->socket_fd = pool_take(conn, &connected);
+    if (conn->socket_fd != -1) {
+        conn->pool_hits++;
+    } else {
+        conn->socket_fd = open_client_socket(conn, &connected);
+        conn->cold_connects++;
+    }
+    
+    conn->is_connected = connected;
     conn->current_iteration_sent = 0;
     conn->current_iteration_received = 0;
+    conn->iteration_start_ns = now_monotonic_ns();
+    memset(&conn->rx_state, 0, sizeof(conn->rx_state));
+    
+    if (g_ctx.tls_enabled && tls_conn_start(&conn->tls, conn->socket_fd) == -1) {
+        printf("CLIENT: TLS setup failed for connection %d\n", conn->thread_index);
+        exit(1);
+    }
     
     return 0;
 }
 
+// Check whether a nonblocking connect() has completed
+static void check_connected(client_connection_meta_t *conn) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(conn->socket_fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0) {
+        conn->is_connected = 1;
+    } else {
+        printf("CLIENT: Connection failed for connection %d: %s\n", 
+               conn->thread_index, strerror(error));
+        exit(1);
+    }
+}
+
+// Add or drop EPOLLOUT. A replay drops it while a connection has no
+// released bytes to send (or its iteration is queued), so level-triggered
+// EPOLLOUT does not wake the loop for nothing between trace records.
+// Other runs leave it armed, as the send path always has.
+static void set_write_interest(client_connection_meta_t *conn, int on) {
+    if (conn->want_write == on) {
+        return;
+    }
+    struct epoll_event event;
+    event.events = on ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.ptr = conn;
+    epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_MOD, conn->socket_fd, &event);
+    conn->want_write = on;
+}
+
+// Drive a nonblocking TLS handshake. Epoll interest follows the direction
+// OpenSSL waits on; once done the connection goes back to EPOLLIN | EPOLLOUT
+// and the time since connect() is recorded as handshake latency.
+static int client_handshake(client_connection_meta_t *conn) {
+    if (!conn->is_connected) {
+        check_connected(conn);
+    }
+    
+    int rc = tls_conn_handshake(&conn->tls);
+    if (rc == TLS_IO_ERROR || rc == TLS_IO_CLOSED) {
+        printf("CLIENT: TLS handshake failed on connection %d\n", conn->thread_index);
+        exit(1);
+    }
+    if (rc == TLS_IO_DONE) {
+        histogram_record(&g_ctx.client_handshake_latency, now_monotonic_ns() - conn->iteration_start_ns);
+    }
+    
+    struct epoll_event event;
+    event.events = rc == TLS_IO_WANT_READ ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+    event.data.ptr = conn;
+    epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_MOD, conn->socket_fd, &event);
+    conn->want_write = rc != TLS_IO_WANT_READ;
+    return rc;
+}
+
+static void close_connection(client_connection_meta_t *conn) {
+    epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_DEL, conn->socket_fd, NULL);
+    tls_conn_free(&conn->tls);
+    close(conn->socket_fd);
+    conn->socket_fd = -1;
+    conn->is_connected = 0;
+}
+
+// Begin an iteration: connect (or take a spare) and wait for writability
+static void start_connection(client_connection_meta_t *conn) {
+    connect_to_server(conn);
+    
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.ptr = conn;
+    if (epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_ADD, conn->socket_fd, &event) == -1) {
+        perror("epoll_ctl add client connection");
+        exit(1);
+    }
+    conn->want_write = 1;
+}
+
+// Startup ramp (--ramp-rate / --ramp-time): number of the initial connects
+// (every connection, then every pool spare) that may have been started
+// elapsed_ms into the run. Without a ramp they all start at once.
+static int ramp_allowed(uint64_t elapsed_ms, int total) {
+    uint64_t allowed;
+    
+    if (g_ctx.ramp_rate > 0) {
+        allowed = (elapsed_ms + 1) * g_ctx.ramp_rate;
+    } else if (g_ctx.ramp_time_ms > 0) {
+        allowed = (uint64_t)total * elapsed_ms / g_ctx.ramp_time_ms + 1;
+    } else {
+        return total;
+    }
+    return allowed < (uint64_t)total ? (int)allowed : total;
+}
+
+// Issue initial connect number n: connections first, so load starts on
+// every port before any spare is opened, then spares round-robin
+static void ramp_issue(int n) {
+    if (n < g_ctx.num_threads) {
+        start_connection(&g_ctx.client_connections[n]);
+    } else {
+        pool_add_spare(&g_ctx.client_connections[(n - g_ctx.num_threads) % g_ctx.num_threads]);
+    }
+}
+
+// Replay: hand out the bytes of every trace record that is due, and wake up
+// the send path of established connections that have been given something
+// to send. Returns 1 once the whole trace has been sent.
+static int replay_pass(void) {
+    int pending = 0;
+    
+    trace_replay_release();
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        client_connection_meta_t *conn = &g_ctx.client_connections[i];
+        if (conn->replay_credit == 0) {
+            continue;
+        }
+        pending = 1;
+        if (conn->socket_fd != -1 && conn->is_connected && conn->tls.state != TLS_STATE_HANDSHAKE &&
+            conn->current_iteration_sent < g_ctx.iteration_send_bytes) {
+            set_write_interest(conn, 1);
+        }
+    }
+    return !pending && trace_replay_done();
+}
+
+// Warm-up is over: restart every counter so the results cover only the
+// measurement window. Echo still owed for bytes sent during warm-up will
+// arrive inside the window, so the request bytes still waiting for their
+// response are carried over as sent to keep the sent/received totals
+// comparable.
+static void reset_counters(void) {
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        client_connection_meta_t *conn = &g_ctx.client_connections[i];
+        conn->reconnect_count = 0;
+        conn->total_bytes_sent = protocol_outstanding_request_bytes(conn->current_iteration_sent,
+                                                                    conn->current_iteration_received);
+        conn->total_bytes_received = 0;
+        conn->total_responses = 0;
+        conn->pool_hits = 0;
+        conn->cold_connects = 0;
+    }
+    g_ctx.errors_connection = 0;
+    g_ctx.errors_io = 0;
+    g_ctx.errors_system = 0;
+    g_ctx.errors_other = 0;
+    histogram_reset(&g_ctx.client_latency);
+    histogram_reset(&g_ctx.client_handshake_latency);
+    memset(&g_ctx.tls_stats, 0, sizeof(g_ctx.tls_stats));
+    loop_stats_reset(&g_ctx.client_loop);
+}
+
+// Start the shutdown drain: stop sending and keep only the connections that
+// still wait for echoed data. Returns the number of connections left open.
+static int start_drain(void) {
+    int open_connections = 0;
+    
+    epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_DEL, g_ctx.shutdown_fd, NULL);
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        client_connection_meta_t *conn = &g_ctx.client_connections[i];
+        pool_close(conn);
+        if (conn->socket_fd == -1) {
+            continue;
+        }
+        // Let a handshake the server has already seen finish, so closing
+        // does not look like a failed handshake on its side
+        if (conn->is_connected && conn->tls.state == TLS_STATE_HANDSHAKE) {
+            open_connections++;
+            continue;
+        }
+        if (!conn->is_connected ||
+            conn->current_iteration_received >= protocol_expected_response_bytes(conn->current_iteration_sent)) {
+            close_connection(conn);
+            continue;
+        }
+        // Flush a corked tail, then wait for the echo only
+        if (g_ctx.tuning.cork > 0) {
+            tuning_cork(conn->socket_fd, 0);
+        }
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = conn;
+        epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_MOD, conn->socket_fd, &event);
+        conn->want_write = 0;
+        open_connections++;
+    }
+    return open_connections;
+}
+
 int run_client(void) {
-    printf("Starting client with %d connections to %s:%d-%d\n", 
-           g_ctx.num_threads, g_ctx.listen_ip, g_ctx.listen_port_start, 
-           g_ctx.listen_port_start + g_ctx.num_threads - 1);
+    if (g_ctx.udp) {
+        return run_udp_client();
+    }
+    
+    printf("Starting %s client with %d connections to %s ports %d-%d\n", 
+           transport_name(g_ctx.transport), g_ctx.num_threads, g_ctx.listen_ip, 
+           g_ctx.listen_port_start, g_ctx.listen_port_start + g_ctx.num_threads - 1);
     
     // Allocate client connection metadata
     g_ctx.client_connections = calloc(g_ctx.num_threads, sizeof(client_connection_meta_t));
@@ -53,7 +316,15 @@ int run_client(void) {
         exit(1);
     }
     
-    // Initialize connections
+    if (g_ctx.pool_size > 0) {
+        g_ctx.client_pool_fds = calloc((size_t)g_ctx.num_threads * g_ctx.pool_size, sizeof(int));
+        if (!g_ctx.client_pool_fds) {
+            perror("calloc");
+            exit(1);
+        }
+    }
+    
+    // Initialize connections; they are connected by the startup ramp
     for (int i = 0; i < g_ctx.num_threads; i++) {
         g_ctx.client_connections[i].thread_index = i;
         g_ctx.client_connections[i].port = g_ctx.listen_port_start + i;
@@ -61,32 +332,99 @@ int run_client(void) {
         g_ctx.client_connections[i].reconnect_count = 0;
         g_ctx.client_connections[i].total_bytes_sent = 0;
         g_ctx.client_connections[i].total_bytes_received = 0;
-        
-        connect_to_server(&g_ctx.client_connections[i]);
-        
-        struct epoll_event event;
-        event.events = EPOLLIN | EPOLLOUT;
-        event.data.ptr = &g_ctx.client_connections[i];
-        if (epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_ADD, 
-                     g_ctx.client_connections[i].socket_fd, &event) == -1) {
-            perror("epoll_ctl add client connection");
-            exit(1);
-        }
+        g_ctx.client_connections[i].pool_fds = g_ctx.client_pool_fds ?
+            g_ctx.client_pool_fds + (size_t)i * g_ctx.pool_size : NULL;
     }
     
+    // The shutdown eventfd is the only entry without a connection pointer
+    struct epoll_event shutdown_event;
+    shutdown_event.events = EPOLLIN;
+    shutdown_event.data.ptr = NULL;
+    if (epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_ADD, g_ctx.shutdown_fd, &shutdown_event) == -1) {
+        perror("epoll_ctl add shutdown eventfd");
+        exit(1);
+    }
+    int draining = 0;
+    int drain_open = 0;
+    uint64_t drain_deadline_ms = 0;
+    uint64_t bytes_received_total = 0;  // Running total for the measurement window
+    int ramp_total = g_ctx.num_threads * (1 + g_ctx.pool_size);
+    int ramp_issued = 0;
+    uint64_t ramp_start_ms = now_monotonic_ms();
+    
     struct epoll_event events[MAX_EVENTS];
-    char send_buffer[BUFFER_SIZE];
-    char recv_buffer[BUFFER_SIZE];
+    // With TLS, read whole records so none stays buffered inside OpenSSL
+    // where epoll cannot see it
+    char recv_buffer[TLS_RECORD_SIZE];
+    size_t recv_len = g_ctx.tls_enabled ? sizeof(recv_buffer) : BUFFER_SIZE;
     time_t last_stats_time = time(NULL);
-    int stats_printed = 0;
+    int stats_lines = 0;
+    uint64_t last_tcp_info_ms = 0;
+    tcp_info_agg_t tcp_info_agg;
+    loop_stats_t last_loop = {0};
+    
+    tcp_info_agg_reset(&tcp_info_agg);
     
-    // Fill send buffer with pattern
-    memset(send_buffer, 0xAA, BUFFER_SIZE);
+    // Fill send buffer with pattern, or with back-to-back request frames that
+    // the send path walks through cyclically so frames are never split wrongly
+    size_t send_buffer_len = BUFFER_SIZE;
+    if (g_ctx.protocol->framed && g_ctx.request_wire_size > send_buffer_len) {
+        send_buffer_len = g_ctx.request_wire_size;
+    }
+    char *send_buffer = malloc(send_buffer_len);
+    if (!send_buffer) {
+        perror("malloc");
+        exit(1);
+    }
+    if (g_ctx.protocol->framed) {
+        send_buffer_len = protocol_build_requests(send_buffer, send_buffer_len);
+    } else {
+        memset(send_buffer, 0xAA, send_buffer_len);
+    }
+    
+    if (g_ctx.record_path && trace_record_open(g_ctx.record_path) != 0) {
+        exit(1);
+    }
+    int replay_finished = 0;
+    if (g_ctx.replay_path) {
+        if (trace_replay_connections() > (uint32_t)g_ctx.num_threads) {
+            printf("CLIENT: Trace has %u connections, folding them onto %d\n",
+                   trace_replay_connections(), g_ctx.num_threads);
+        }
+        trace_replay_start();
+    }
     
     printf("Client started, target data size per connection: %lu bytes\n", g_ctx.data_size_before_reconnect);
     
     while (g_ctx.running) {
-        int nfds = epoll_wait(g_ctx.client_epoll_fd, events, MAX_EVENTS, 100);
+        // Startup ramp; the pools are only topped up once it is complete
+        if (ramp_issued < ramp_total && !draining) {
+            uint64_t elapsed_ms = now_monotonic_ms() - ramp_start_ms;
+            int allowed = ramp_allowed(elapsed_ms, ramp_total);
+            while (ramp_issued < allowed) {
+                ramp_issue(ramp_issued++);
+            }
+            if (ramp_issued == ramp_total && (g_ctx.ramp_rate > 0 || g_ctx.ramp_time_ms > 0)) {
+                printf("RAMP: %d connections and %d spares started over %lu ms\n",
+                       g_ctx.num_threads, ramp_total - g_ctx.num_threads, elapsed_ms);
+                stats_lines = 0;
+            }
+        } else if (g_ctx.pool_size > 0 && !draining) {
+            pool_top_up();
+        }
+        
+        int timeout_ms = ramp_issued < ramp_total ? 1 : 100;
+        if (g_ctx.replay_path && !draining && !replay_finished) {
+            if (replay_pass()) {
+                printf("REPLAY: trace complete\n");
+                stats_lines = 0;
+                replay_finished = 1;
+                request_shutdown();
+            }
+            timeout_ms = trace_replay_timeout_ms(timeout_ms);
+        }
+        
+        int nfds = loop_wait(&g_ctx.client_loop, g_ctx.client_epoll_fd, events, MAX_EVENTS, timeout_ms);
         if (nfds == -1) {
             if (errno != EINTR) {
                 perror("epoll_wait");
@@ -97,32 +435,50 @@ int run_client(void) {
         
         for (int i = 0; i < nfds; i++) {
             client_connection_meta_t *conn = (client_connection_meta_t *)events[i].data.ptr;
+            if (conn == NULL || conn->socket_fd == -1) {
+                continue; // Shutdown eventfd, or closed earlier in this batch
+            }
             
-            if (events[i].events & EPOLLOUT) {
+            if (conn->tls.state == TLS_STATE_HANDSHAKE) {
+                if (client_handshake(conn) == TLS_IO_DONE && draining) {
+                    // Nothing was sent on it, so nothing is owed
+                    close_connection(conn);
+                    drain_open--;
+                }
+                continue;
+            }
+            
+            if ((events[i].events & EPOLLOUT) && !draining) {
                 if (!conn->is_connected) {
-                    // Check if connection is now established
-                    int error = 0;
-                    socklen_t len = sizeof(error);
-                    if (getsockopt(conn->socket_fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0) {
-                        conn->is_connected = 1;
-                    } else {
-                        printf("CLIENT: Connection failed for connection %d: %s\n", 
-                               conn->thread_index, strerror(error));
-                        exit(1);
-                    }
+                    check_connected(conn);
                 }
                 
-                // Send data if we haven't sent enough yet
-                if (conn->current_iteration_sent < g_ctx.data_size_before_reconnect) {
-                    uint64_t to_send = BUFFER_SIZE;
-                    if (conn->current_iteration_sent + to_send > g_ctx.data_size_before_reconnect) {
-                        to_send = g_ctx.data_size_before_reconnect - conn->current_iteration_sent;
+                // Send data if we haven't sent enough yet (and, when
+                // replaying, only what the trace has released so far)
+                if (conn->current_iteration_sent < g_ctx.iteration_send_bytes &&
+                    (!g_ctx.replay_path || conn->replay_credit > 0)) {
+                    size_t offset = conn->current_iteration_sent % send_buffer_len;
+                    uint64_t to_send = send_buffer_len - offset;
+                    if (conn->current_iteration_sent + to_send > g_ctx.iteration_send_bytes) {
+                        to_send = g_ctx.iteration_send_bytes - conn->current_iteration_sent;
+                    }
+                    if (g_ctx.replay_path && to_send > conn->replay_credit) {
+                        to_send = conn->replay_credit;
                     }
                     
-                    ssize_t bytes_sent = write(conn->socket_fd, send_buffer, (size_t)to_send);
+                    ssize_t bytes_sent = tls_conn_write(&conn->tls, conn->socket_fd, send_buffer + offset, (size_t)to_send);
                     if (bytes_sent > 0) {
                         conn->current_iteration_sent += bytes_sent;
                         conn->total_bytes_sent += bytes_sent;
+                        trace_record_add(conn->thread_index, (uint32_t)bytes_sent);
+                        if (g_ctx.replay_path) {
+                            conn->replay_credit -= (uint64_t)bytes_sent;
+                        }
+                        // Flush the corked tail once the whole iteration is queued
+                        if (g_ctx.tuning.cork > 0 &&
+                            conn->current_iteration_sent >= g_ctx.iteration_send_bytes) {
+                            tuning_cork(conn->socket_fd, 0);
+                        }
                     } else if (bytes_sent == -1) {
                         if (errno != EAGAIN && errno != EWOULDBLOCK) {
                             printf("CLIENT: Write error on connection %d: %s\n", 
@@ -134,10 +490,14 @@ int run_client(void) {
                         exit(1);
                     }
                 }
+                if (g_ctx.replay_path && (conn->replay_credit == 0 ||
+                                          conn->current_iteration_sent >= g_ctx.iteration_send_bytes)) {
+                    set_write_interest(conn, 0);
+                }
             }
             
             if (events[i].events & EPOLLIN) {
-                ssize_t bytes_read = read(conn->socket_fd, recv_buffer, sizeof(recv_buffer));
+                ssize_t bytes_read = tls_conn_read(&conn->tls, conn->socket_fd, recv_buffer, recv_len);
                 
                 if (bytes_read == 0) {
                     printf("CLIENT %d: SERVER CLOSED CONNECTION fd=%d unexpectedly (sent=%lu, recv=%lu)\n", 
@@ -154,62 +514,144 @@ int run_client(void) {
                     
                 } else {
                     // Successfully read echoed data
+                    if (g_ctx.tuning.quickack > 0) {
+                        tuning_rearm_quickack(conn->socket_fd);
+                    }
                     conn->current_iteration_received += bytes_read;
                     conn->total_bytes_received += bytes_read;
+                    bytes_received_total += bytes_read;
+                    if (g_ctx.protocol->framed) {
+                        int responses = protocol_consume_responses(&conn->rx_state, recv_buffer, bytes_read);
+                        if (responses < 0) {
+                            printf("CLIENT: Malformed %s response on connection %d\n",
+                                   g_ctx.protocol->name, conn->thread_index);
+                            exit(1);
+                        }
+                        conn->total_responses += responses;
+                    }
                     
-                    // Check if we've received everything we sent
-                    if (conn->current_iteration_received >= g_ctx.data_size_before_reconnect) {
+                    // Check if we've received every response to what we sent
+                    if (conn->current_iteration_received >= g_ctx.iteration_recv_bytes) {
                         // Close connection - server will see this and close its side
-                        epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_DEL, conn->socket_fd, NULL);
-                        close(conn->socket_fd);
+                        close_connection(conn);
                         conn->reconnect_count++;
-                        conn->is_connected = 0;
+                        histogram_record(&g_ctx.client_latency, now_monotonic_ns() - conn->iteration_start_ns);
+                        if (draining) {
+                            drain_open--;
+                            continue;
+                        }
                         
                         // Reset counters for next iteration
                         conn->current_iteration_sent = 0;
                         conn->current_iteration_received = 0;
                         
                         // Reconnect
-                        connect_to_server(conn);
-                        struct epoll_event event;
-                        event.events = EPOLLIN | EPOLLOUT;
-                        event.data.ptr = conn;
-                        if (epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_ADD, conn->socket_fd, &event) == -1) {
-                            perror("epoll_ctl add reconnected client");
-                            exit(1);
-                        }
+                        start_connection(conn);
+                    } else if (draining && conn->current_iteration_received >=
+                               protocol_expected_response_bytes(conn->current_iteration_sent)) {
+                        // Partial iteration fully echoed
+                        close_connection(conn);
+                        drain_open--;
                     }
                 }
             }
         }
         
+        // Graceful shutdown: wait for outstanding echoes up to the deadline
+        if (g_ctx.shutdown_requested && !draining) {
+            draining = 1;
+            drain_open = start_drain();
+            drain_deadline_ms = now_monotonic_ms() + g_ctx.drain_timeout_ms;
+        }
+        if (draining && (drain_open <= 0 || now_monotonic_ms() >= drain_deadline_ms)) {
+            break;
+        }
+        
+        // Warm-up and measurement window
+        if (measure_active() && !draining) {
+            int event = measure_tick(bytes_received_total);
+            if (event == MEASURE_EVENT_STARTED) {
+                reset_counters();
+                g_ctx.run_start_ns = now_monotonic_ns();
+                printf("MEASURE: warm-up complete, counters reset, measurement started\n");
+                stats_lines = 0; // Keep the message visible above the table
+            } else if (event == MEASURE_EVENT_ENDED) {
+                printf("MEASURE: measurement window complete\n");
+                stats_lines = 0;
+                request_shutdown();
+            }
+        }
+        
+        // Periodic TCP_INFO sampling, outside the per-event path
+        if (tcp_info_enabled()) {
+            uint64_t now_ms = now_monotonic_ms();
+            if (now_ms - last_tcp_info_ms >= (uint64_t)g_ctx.tcp_info_interval_ms) {
+                tcp_info_agg_reset(&tcp_info_agg);
+                for (int i = 0; i < g_ctx.num_threads; i++) {
+                    client_connection_meta_t *conn = &g_ctx.client_connections[i];
+                    if (conn->is_connected && tcp_info_should_sample(i) &&
+                        tcp_info_sample(conn->socket_fd, &conn->tcp_info) == 0) {
+                        tcp_info_agg_add(&tcp_info_agg, &conn->tcp_info);
+                    }
+                }
+                last_tcp_info_ms = now_ms;
+            }
+        }
+        
         // Print statistics
         time_t current_time = time(NULL);
         if (current_time - last_stats_time >= g_ctx.refresh_stats_seconds) {
-            if (stats_printed) {
+            if (stats_lines > 0) {
                 // Move cursor up to overwrite previous statistics
-                // 4 lines (header + table header + separator + blank line) + number of connection lines
-                int lines_to_move_up = 4 + g_ctx.num_threads;
-                printf("\033[%dA", lines_to_move_up);
+                printf("\033[%dA\033[J", stats_lines);
             }
             
-            printf("=== Client Statistics ===\n");
-            printf("Connection | Port | Reconnects | Total Sent | Total Recv | Iter Sent | Iter Recv | Status\n");
-            printf("-----------|------|------------|------------|------------|-----------|-----------|----------\n");
+            printf("=== Client Statistics (%s %s) ===", transport_name(g_ctx.transport), g_ctx.listen_ip);
+            if (measure_active()) {
+                char phase[64];
+                measure_format_phase(phase, sizeof(phase));
+                printf(" [%s]", phase);
+            }
+            printf("\n");
+            printf("Connection | Port | Reconnects | Total Sent | Total Recv | Iter Sent | Iter Recv | Status    ");
+            if (tcp_info_enabled()) {
+                printf(" | RTT us  | Cwnd  | Retrans | Unacked B");
+            }
+            printf("\n");
+            printf("-----------|------|------------|------------|------------|-----------|-----------|-----------");
+            if (tcp_info_enabled()) {
+                printf("-|---------|-------|---------|----------");
+            }
+            printf("\n");
+            stats_lines = 3;
             
             for (int i = 0; i < g_ctx.num_threads; i++) {
                 client_connection_meta_t *conn = &g_ctx.client_connections[i];
-                printf("%-10d | %-4d | %-10lu | %-10lu | %-10lu | %-9lu | %-9lu | %s\n", 
+                printf("%-10d | %-4d | %-10lu | %-10lu | %-10lu | %-9lu | %-9lu | %-10s", 
                        conn->thread_index, conn->port, conn->reconnect_count, 
                        conn->total_bytes_sent, conn->total_bytes_received,
                        conn->current_iteration_sent, conn->current_iteration_received,
-                       conn->is_connected ? "Connected" : "Connecting");
+                       conn->socket_fd == -1 ? "Waiting" : conn->is_connected ? "Connected" : "Connecting");
+                if (tcp_info_enabled() && conn->tcp_info.valid) {
+                    printf(" | %-7u | %-5u | %-7u | %u", conn->tcp_info.rtt_us, conn->tcp_info.snd_cwnd,
+                           conn->tcp_info.total_retrans, conn->tcp_info.unacked_bytes);
+                }
+                printf("\n");
+                stats_lines++;
+            }
+            if (tcp_info_enabled()) {
+                tcp_info_print_agg("Sampled", &tcp_info_agg);
+                stats_lines++;
             }
+            loop_print_interval("Interval", &last_loop);
+            stats_lines++;
             printf("\n");
-            stats_printed = 1;
+            stats_lines++;
             last_stats_time = current_time;
         }
     }
     
+    trace_record_close();
+    free(send_buffer);
     return 0;
 } 
\ No newline at end of file
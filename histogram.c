@@ -0,0 +1,93 @@
+#include "network_app.h"
+
+// Log-linear latency histogram: values are bucketed by their power of two
+// and each power of two is split into HISTOGRAM_SUB_BUCKETS linear steps,
+// which keeps the relative error of any percentile below 1/16 (~6%) with a
+// fixed 8 KB footprint and O(1) recording.
+
+static int histogram_bucket_index(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - HISTOGRAM_SUB_BUCKET_BITS;
+    int sub = (int)((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Upper bound of the values that land in a bucket
+static uint64_t histogram_bucket_value(int index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t sub = (uint64_t)(index % HISTOGRAM_SUB_BUCKETS) | HISTOGRAM_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void histogram_reset(latency_histogram_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void histogram_record(latency_histogram_t *h, uint64_t value) {
+    h->counts[histogram_bucket_index(value)]++;
+    if (h->count == 0 || value < h->min) {
+        h->min = value;
+    }
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->sum += value;
+    h->count++;
+}
+
+void histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src) {
+    if (src->count == 0) {
+        return;
+    }
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    if (dst->count == 0 || src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->sum += src->sum;
+    dst->count += src->count;
+}
+
+uint64_t histogram_percentile(const latency_histogram_t *h, double percentile) {
+    if (h->count == 0) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)h->count + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            uint64_t value = histogram_bucket_value(i);
+            return value > h->max ? h->max : value;
+        }
+    }
+    return h->max;
+}
+
+void histogram_print(const char *label, const latency_histogram_t *h) {
+    if (h->count == 0) {
+        printf("  %-22s no samples\n", label);
+        return;
+    }
+    // Values are recorded in nanoseconds and printed in microseconds
+    printf("  %-22s n=%lu min=%.1f avg=%.1f p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f max=%.1f us\n",
+           label, h->count, h->min / 1000.0, (double)h->sum / h->count / 1000.0,
+           histogram_percentile(h, 50.0) / 1000.0, histogram_percentile(h, 90.0) / 1000.0,
+           histogram_percentile(h, 99.0) / 1000.0, histogram_percentile(h, 99.9) / 1000.0,
+           h->max / 1000.0);
+}
@@ -0,0 +1,163 @@
+#include "network_app.h"
+
+// Event loop waits. Every epoll loop waits through loop_wait(), which keeps
+// count of the loop passes and of where the thread's time went: handling
+// events, polling without finding any, or asleep in epoll_wait().
+//
+// With --spin <usec> a loop whose last wait returned events polls epoll
+// with a zero timeout instead of going to sleep, so the next event is
+// picked up without a wakeup through the scheduler. Once it has polled for
+// the spin period without finding anything it falls back to a normal
+// blocking wait, and it spins again as soon as a wait returns events, so an
+// idle run does not burn a core.
+// Callers keep their own timeouts: a spin never outlasts the timeout the
+// caller asked for, so periodic work runs on the same schedule either way.
+
+static uint64_t loop_wait_blocking(loop_stats_t *ls, int epoll_fd, struct epoll_event *events,
+                                   int max_events, int timeout_ms, uint64_t start_ns, int *nfds) {
+    *nfds = epoll_wait(epoll_fd, events, max_events, timeout_ms);
+    uint64_t now_ns = now_monotonic_ns();
+    ls->blocks++;
+    ls->block_ns += now_ns - start_ns;
+    return now_ns;
+}
+
+int loop_wait(loop_stats_t *ls, int epoll_fd, struct epoll_event *events, int max_events, int timeout_ms) {
+    uint64_t start_ns = now_monotonic_ns();
+    uint64_t now_ns = start_ns;
+    int nfds = 0;
+
+    if (ls->mark_ns) {
+        ls->busy_ns += start_ns - ls->mark_ns;
+    }
+    ls->iterations++;
+
+    if (timeout_ms == 0 || (g_ctx.spin_usec > 0 && ls->spinning)) {
+        uint64_t spin_ns = timeout_ms == 0 ? 0 : (uint64_t)g_ctx.spin_usec * 1000;
+        if (timeout_ms > 0 && (uint64_t)timeout_ms * 1000000 < spin_ns) {
+            spin_ns = (uint64_t)timeout_ms * 1000000;
+        }
+        uint64_t deadline_ns = start_ns + spin_ns;
+        do {
+            nfds = epoll_wait(epoll_fd, events, max_events, 0);
+            ls->polls++;
+            now_ns = now_monotonic_ns();
+        } while (nfds == 0 && now_ns < deadline_ns);
+        ls->spin_ns += now_ns - start_ns;
+
+        // Idle for the whole spin period: sleep for what is left of the
+        // caller's timeout
+        if (nfds == 0 && timeout_ms != 0) {
+            int remaining_ms = timeout_ms;
+            if (timeout_ms > 0) {
+                uint64_t spent_ms = (now_ns - start_ns) / 1000000;
+                remaining_ms = spent_ms < (uint64_t)timeout_ms ? timeout_ms - (int)spent_ms : 0;
+            }
+            if (remaining_ms != 0) {
+                ls->fallbacks++;
+                now_ns = loop_wait_blocking(ls, epoll_fd, events, max_events, remaining_ms, now_ns, &nfds);
+            }
+        }
+    } else {
+        now_ns = loop_wait_blocking(ls, epoll_fd, events, max_events, timeout_ms, start_ns, &nfds);
+    }
+
+    // A zero-timeout poll that finds nothing (the caller still has work
+    // queued) does not end a spin
+    if (nfds > 0) {
+        ls->busy++;
+        ls->spinning = 1;
+    } else if (timeout_ms != 0) {
+        ls->spinning = 0;
+    }
+    ls->mark_ns = now_ns;
+    return nfds;
+}
+
+// Start the counters over (end of warm-up); the spin state carries on
+void loop_stats_reset(loop_stats_t *ls) {
+    int spinning = ls->spinning;
+    uint64_t mark_ns = ls->mark_ns;
+
+    memset(ls, 0, sizeof(*ls));
+    ls->spinning = spinning;
+    ls->mark_ns = mark_ns;
+}
+
+void loop_stats_merge(loop_stats_t *dst, const loop_stats_t *src) {
+    dst->iterations += src->iterations;
+    dst->busy += src->busy;
+    dst->polls += src->polls;
+    dst->blocks += src->blocks;
+    dst->fallbacks += src->fallbacks;
+    dst->busy_ns += src->busy_ns;
+    dst->spin_ns += src->spin_ns;
+    dst->block_ns += src->block_ns;
+}
+
+// Server threads are merged into one set of counters. Other threads'
+// counters are read without a lock, like the other periodic totals.
+static void loop_collect(loop_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (g_ctx.is_server) {
+        for (int i = 0; i < g_ctx.num_threads; i++) {
+            loop_stats_merge(out, &g_ctx.server_threads[i].loop);
+        }
+    } else {
+        loop_stats_merge(out, &g_ctx.client_loop);
+    }
+}
+
+static void loop_print_split(const loop_stats_t *ls) {
+    double total_ns = (double)(ls->busy_ns + ls->spin_ns + ls->block_ns);
+    if (total_ns <= 0) {
+        total_ns = 1;
+    }
+
+    printf("%lu passes, %.1f%% with events; time %.1f%% busy, %.1f%% polling, %.1f%% blocked",
+           ls->iterations, ls->iterations ? 100.0 * ls->busy / ls->iterations : 0.0,
+           100.0 * ls->busy_ns / total_ns, 100.0 * ls->spin_ns / total_ns, 100.0 * ls->block_ns / total_ns);
+}
+
+void loop_print_summary(void) {
+    loop_stats_t ls;
+    loop_collect(&ls);
+
+    printf("  %-22s ", "Event loop:");
+    loop_print_split(&ls);
+    printf("\n");
+    if (g_ctx.spin_usec > 0) {
+        printf("  %-22s %d us idle limit: %lu polls, %lu blocking waits, %lu fallbacks after idle\n",
+               "Spin:", g_ctx.spin_usec, ls.polls, ls.blocks, ls.fallbacks);
+    }
+}
+
+static uint64_t loop_since(uint64_t now, uint64_t prev) {
+    return now >= prev ? now - prev : now;
+}
+
+// One line for the periodic stats covering the loop passes since the last
+// call; *prev holds the counters seen then
+void loop_print_interval(const char *label, loop_stats_t *prev) {
+    loop_stats_t ls, delta;
+    loop_collect(&ls);
+
+    // Counters start over at the end of warm-up (each server thread on its
+    // own next pass), so a counter below its snapshot counts from zero
+    delta.iterations = loop_since(ls.iterations, prev->iterations);
+    delta.busy = loop_since(ls.busy, prev->busy);
+    delta.polls = loop_since(ls.polls, prev->polls);
+    delta.blocks = loop_since(ls.blocks, prev->blocks);
+    delta.fallbacks = loop_since(ls.fallbacks, prev->fallbacks);
+    delta.busy_ns = loop_since(ls.busy_ns, prev->busy_ns);
+    delta.spin_ns = loop_since(ls.spin_ns, prev->spin_ns);
+    delta.block_ns = loop_since(ls.block_ns, prev->block_ns);
+    *prev = ls;
+
+    printf("%s Event loop: ", label);
+    loop_print_split(&delta);
+    if (g_ctx.spin_usec > 0) {
+        printf("; spin %lu polls, %lu fallbacks", delta.polls, delta.fallbacks);
+    }
+    printf("\n");
+}
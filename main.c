@@ -8,12 +8,82 @@ void print_usage(const char *program_name) {
     printf("\nRequired Options (All modes):\n");
     printf("  -t, --threads <num>           Number of threads\n");
     printf("  -m, --mode <client|server>    Run as client or server\n");
-    printf("  -i, --ip <IP>                 Listen/Connect IP address\n");
+    printf("  -i, --ip <IP|path>            Listen/Connect IPv4/IPv6 address or Unix socket path\n");
     printf("  -p, --port <port>             Listen/Connect port start number\n");
     printf("\nRequired Options (Client only):\n");
     printf("  -d, --data-size <bytes>       Data size before reconnect\n");
     printf("\nOptional Options:\n");
     printf("  -r, --refresh <seconds>       Refresh stats interval (default: 1)\n");
+    printf("  -x, --transport <inet|inet6|unix>\n");
+    printf("                                Socket family (default: detected from -i)\n");
+    printf("  --max-conns <n>               Server connections per thread (default: %d)\n",
+           MAX_CONNECTIONS_PER_THREAD);
+    printf("\nProtocol Options:\n");
+    printf("  --protocol <raw|framed|reqresp>\n");
+    printf("                                raw byte echo (default), length-prefixed frame echo,\n");
+    printf("                                or request N bytes / respond M bytes\n");
+    printf("  --request-size <bytes>        Request payload size N (default: %d)\n", DEFAULT_REQUEST_SIZE);
+    printf("  --response-size <bytes>       Response payload size M for reqresp (default: N)\n");
+    printf("\nUDP Options:\n");
+    printf("  --udp                         Echo datagrams instead of TCP streams (-d not needed)\n");
+    printf("  --datagram-size <bytes>       Client datagram size, 16-byte header included (default: %d)\n",
+           DEFAULT_DATAGRAM_SIZE);
+    printf("  --udp-batch <n>               Messages per recvmmsg()/sendmmsg() (default: %d, max: %d)\n",
+           DEFAULT_UDP_BATCH, UDP_MAX_BATCH);
+    printf("  --udp-window <n>              Client datagrams in flight per socket (default: %d)\n",
+           DEFAULT_UDP_WINDOW);
+    printf("  --gso <0|1>                   Send with UDP segmentation offload (default: 0)\n");
+    printf("  --gro <0|1>                   Receive with UDP generic receive offload (default: 0)\n");
+    printf("\nServer Scheduling Options:\n");
+    printf("  --sched <fifo|rr|drr>         Serve reads in epoll order (default), or round robin /\n");
+    printf("                                deficit round robin over a per-thread run queue\n");
+    printf("  --conn-budget <bytes>         Bytes a connection may read per rr/drr visit (default: %d)\n",
+           DEFAULT_CONN_BUDGET);
+    printf("\nClient Connection Options:\n");
+    printf("  --ramp-rate <n>               Start n connections per millisecond (default: all at once)\n");
+    printf("  --ramp-time <seconds>         Or spread the startup connects evenly over this long\n");
+    printf("  --pool <n>                    Pre-connected spare sockets per connection, max %d (default: 0)\n",
+           MAX_POOL_SIZE);
+    printf("\nWorkload Traces (Client only):\n");
+    printf("  --record <file>               Write every send (connection, time, size) to a trace file\n");
+    printf("  --replay <file>               Send what a recorded trace sent, when it sent it\n");
+    printf("  --replay-speed <x>            Replay time scale: 2 = twice as fast, 0 = as fast as possible\n");
+    printf("                                (default: 1)\n");
+    printf("  --trace-convert <in> <out>    Convert a time_us,connection,size CSV to a trace file, or a\n");
+    printf("                                trace file to CSV when <out> ends in .csv, then exit\n");
+    printf("\nTLS Options:\n");
+    printf("  --tls                         Encrypt connections (self-signed certificate generated at startup)\n");
+    printf("  --tls-version <1.2|1.3>       Protocol version (default: 1.2, widest kTLS support)\n");
+    printf("  --ktls <0|1>                  Offload established sessions to kernel TLS (default: 1)\n");
+    printf("\nSocket Tuning Options:\n");
+    printf("  --tuning <default|latency|throughput|custom>\n");
+    printf("                                Socket option profile (default: default)\n");
+    printf("  --nodelay <0|1>               TCP_NODELAY\n");
+    printf("  --quickack <0|1>              TCP_QUICKACK (re-armed after every read)\n");
+    printf("  --busy-poll <usec>            SO_BUSY_POLL\n");
+    printf("  --prefer-busy-poll <0|1>      SO_PREFER_BUSY_POLL\n");
+    printf("  --sndbuf <bytes>              SO_SNDBUF\n");
+    printf("  --rcvbuf <bytes>              SO_RCVBUF\n");
+    printf("  --notsent-lowat <bytes>       TCP_NOTSENT_LOWAT\n");
+    printf("  --cork <0|1>                  TCP_CORK around each write batch\n");
+    printf("\nEvent Loop:\n");
+    printf("  --spin <usec>                 Poll epoll without sleeping until events have been idle\n");
+    printf("                                this long, then block again (default: 0 = always block)\n");
+    printf("\nTCP_INFO Sampling:\n");
+    printf("  --tcp-info <N>                Sample every Nth connection (default: 0 = off)\n");
+    printf("  --tcp-info-interval <ms>      Sampling period (default: 1000)\n");
+    printf("\nMeasurement Windows:\n");
+    printf("  --warmup <seconds>            Exclude the first seconds from the results\n");
+    printf("  --duration <seconds>          Stop after measuring this long (default: until signalled)\n");
+    printf("  --steady-state                End warm-up once throughput is stable (--warmup = max, default: %d)\n",
+           DEFAULT_STEADY_MAX_WARMUP_S);
+    printf("  --steady-cv <percent>         Max throughput coefficient of variation (default: %d)\n",
+           DEFAULT_STEADY_CV_PERCENT);
+    printf("  --steady-window <intervals>   1-second intervals the CV is computed over (default: %d)\n",
+           DEFAULT_STEADY_WINDOW);
+    printf("\nShutdown:\n");
+    printf("  --drain-timeout <ms>          Time allowed to finish pending echoes (default: %d)\n",
+           DEFAULT_DRAIN_TIMEOUT_MS);
     printf("  -h, --help                    Show this help message\n");
     printf("\nExample Usage:\n");
     printf("  Server: %s -t 4 -m server -i 127.0.0.1 -p 8000\n", program_name);
@@ -22,6 +92,40 @@ void print_usage(const char *program_name) {
     printf("  Server will create 4 listen sockets on ports 8000-8003\n");
     printf("  Client will connect to each server port and send 1024 bytes before reconnecting\n");
     printf("  Statistics will refresh every 1 second (server) or 2 seconds (client)\n");
+    printf("\nTransports:\n");
+    printf("  -i ::1              IPv6 (any address containing ':')\n");
+    printf("  -i /tmp/iex.sock    Unix socket per thread: /tmp/iex.sock.8000, /tmp/iex.sock.8001, ...\n");
+    printf("  -i @iex             Unix abstract namespace: @iex.8000, @iex.8001, ...\n");
+}
+
+// Parse "<option> <int>" where the value must be >= min_value
+static int parse_int_option(int argc, char *argv[], int *i, int min_value, int *out) {
+    const char *option = argv[*i];
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "Error: %s requires a value\n", option);
+        return -1;
+    }
+    char *end;
+    long value = strtol(argv[++(*i)], &end, 10);
+    if (*end != '\0' || value < min_value || value > 0x7fffffffL) {
+        fprintf(stderr, "Error: %s must be an integer >= %d\n", option, min_value);
+        return -1;
+    }
+    *out = (int)value;
+    return 0;
+}
+
+// On/off switch documented as <0|1>
+static int parse_switch_option(int argc, char *argv[], int *i, int *out) {
+    const char *option = argv[*i];
+    if (parse_int_option(argc, argv, i, 0, out) != 0) {
+        return -1;
+    }
+    if (*out > 1) {
+        fprintf(stderr, "Error: %s must be 0 or 1\n", option);
+        return -1;
+    }
+    return 0;
 }
 
 int parse_arguments(int argc, char *argv[]) {
@@ -29,6 +133,23 @@ int parse_arguments(int argc, char *argv[]) {
     
     // Set defaults
     g_ctx.refresh_stats_seconds = 1;
+    g_ctx.tcp_info_interval_ms = 1000;
+    g_ctx.drain_timeout_ms = DEFAULT_DRAIN_TIMEOUT_MS;
+    g_ctx.measure.steady_cv_percent = DEFAULT_STEADY_CV_PERCENT;
+    g_ctx.measure.steady_window = DEFAULT_STEADY_WINDOW;
+    int warmup_s = -1, duration_s = 0, steady_cv = DEFAULT_STEADY_CV_PERCENT;
+    int request_size = DEFAULT_REQUEST_SIZE, response_size = -1;
+    int ramp_time_s = 0;
+    g_ctx.protocol = protocol_default();
+    g_ctx.tls_version = 12;
+    g_ctx.tls_ktls = 1;
+    g_ctx.datagram_size = DEFAULT_DATAGRAM_SIZE;
+    g_ctx.udp_batch = DEFAULT_UDP_BATCH;
+    g_ctx.udp_window = DEFAULT_UDP_WINDOW;
+    g_ctx.max_connections = MAX_CONNECTIONS_PER_THREAD;
+    g_ctx.conn_budget = DEFAULT_CONN_BUDGET;
+    g_ctx.replay_speed = 1.0;
+    tuning_init_overrides();
     
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
@@ -99,6 +220,164 @@ int parse_arguments(int argc, char *argv[]) {
                 fprintf(stderr, "Error: Refresh interval must be greater than 0\n");
                 return -1;
             }
+        } else if (strcmp(argv[i], "-x") == 0 || strcmp(argv[i], "--transport") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: -x/--transport requires a value\n");
+                return -1;
+            }
+            g_ctx.transport = transport_parse(argv[++i]);
+            if (g_ctx.transport < 0) {
+                fprintf(stderr, "Error: Transport must be 'inet', 'inet6' or 'unix'\n");
+                return -1;
+            }
+            g_ctx.transport_set = 1;
+        } else if (strcmp(argv[i], "--protocol") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --protocol requires a value\n");
+                return -1;
+            }
+            g_ctx.protocol = protocol_find(argv[++i]);
+            if (!g_ctx.protocol) {
+                fprintf(stderr, "Error: Protocol must be 'raw', 'framed' or 'reqresp'\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--request-size") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &request_size) != 0) return -1;
+        } else if (strcmp(argv[i], "--response-size") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &response_size) != 0) return -1;
+        } else if (strcmp(argv[i], "--udp") == 0) {
+            g_ctx.udp = 1;
+        } else if (strcmp(argv[i], "--datagram-size") == 0) {
+            if (parse_int_option(argc, argv, &i, UDP_HEADER_SIZE, &g_ctx.datagram_size) != 0) return -1;
+            if (g_ctx.datagram_size > UDP_MAX_DATAGRAM) {
+                fprintf(stderr, "Error: --datagram-size must be at most %d\n", UDP_MAX_DATAGRAM);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--udp-batch") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.udp_batch) != 0) return -1;
+            if (g_ctx.udp_batch > UDP_MAX_BATCH) {
+                fprintf(stderr, "Error: --udp-batch must be at most %d\n", UDP_MAX_BATCH);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--udp-window") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.udp_window) != 0) return -1;
+        } else if (strcmp(argv[i], "--gso") == 0) {
+            if (parse_switch_option(argc, argv, &i, &g_ctx.udp_gso) != 0) return -1;
+        } else if (strcmp(argv[i], "--gro") == 0) {
+            if (parse_switch_option(argc, argv, &i, &g_ctx.udp_gro) != 0) return -1;
+        } else if (strcmp(argv[i], "--record") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --record requires a file name\n");
+                return -1;
+            }
+            g_ctx.record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --replay requires a file name\n");
+                return -1;
+            }
+            g_ctx.replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --replay-speed requires a value\n");
+                return -1;
+            }
+            char *end;
+            g_ctx.replay_speed = strtod(argv[++i], &end);
+            if (*end != '\0' || !isfinite(g_ctx.replay_speed) || g_ctx.replay_speed < 0) {
+                fprintf(stderr, "Error: --replay-speed must be a number >= 0\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--tls") == 0) {
+            g_ctx.tls_enabled = 1;
+        } else if (strcmp(argv[i], "--tls-version") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --tls-version requires a value\n");
+                return -1;
+            }
+            const char *version = argv[++i];
+            if (strcmp(version, "1.2") == 0) {
+                g_ctx.tls_version = 12;
+            } else if (strcmp(version, "1.3") == 0) {
+                g_ctx.tls_version = 13;
+            } else {
+                fprintf(stderr, "Error: TLS version must be '1.2' or '1.3'\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--ktls") == 0) {
+            if (parse_switch_option(argc, argv, &i, &g_ctx.tls_ktls) != 0) return -1;
+        } else if (strcmp(argv[i], "--tuning") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --tuning requires a value\n");
+                return -1;
+            }
+            g_ctx.tuning_profile = tuning_parse_profile(argv[++i]);
+            if (g_ctx.tuning_profile < 0) {
+                fprintf(stderr, "Error: Tuning profile must be 'default', 'latency', 'throughput' or 'custom'\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--nodelay") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.tuning_override.nodelay) != 0) return -1;
+        } else if (strcmp(argv[i], "--quickack") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.tuning_override.quickack) != 0) return -1;
+        } else if (strcmp(argv[i], "--busy-poll") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.tuning_override.busy_poll_usec) != 0) return -1;
+        } else if (strcmp(argv[i], "--prefer-busy-poll") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.tuning_override.prefer_busy_poll) != 0) return -1;
+        } else if (strcmp(argv[i], "--spin") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.spin_usec) != 0) return -1;
+        } else if (strcmp(argv[i], "--sndbuf") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.tuning_override.sndbuf) != 0) return -1;
+        } else if (strcmp(argv[i], "--rcvbuf") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.tuning_override.rcvbuf) != 0) return -1;
+        } else if (strcmp(argv[i], "--notsent-lowat") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.tuning_override.notsent_lowat) != 0) return -1;
+        } else if (strcmp(argv[i], "--cork") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.tuning_override.cork) != 0) return -1;
+        } else if (strcmp(argv[i], "--tcp-info") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.tcp_info_every) != 0) return -1;
+        } else if (strcmp(argv[i], "--tcp-info-interval") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.tcp_info_interval_ms) != 0) return -1;
+        } else if (strcmp(argv[i], "--sched") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --sched requires a value\n");
+                return -1;
+            }
+            g_ctx.sched = sched_parse(argv[++i]);
+            if (g_ctx.sched < 0) {
+                fprintf(stderr, "Error: Scheduler must be 'fifo', 'rr' or 'drr'\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--conn-budget") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.conn_budget) != 0) return -1;
+        } else if (strcmp(argv[i], "--ramp-rate") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.ramp_rate) != 0) return -1;
+        } else if (strcmp(argv[i], "--ramp-time") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &ramp_time_s) != 0) return -1;
+        } else if (strcmp(argv[i], "--pool") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.pool_size) != 0) return -1;
+            if (g_ctx.pool_size > MAX_POOL_SIZE) {
+                fprintf(stderr, "Error: --pool must be at most %d\n", MAX_POOL_SIZE);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--max-conns") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &g_ctx.max_connections) != 0) return -1;
+        } else if (strcmp(argv[i], "--drain-timeout") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &g_ctx.drain_timeout_ms) != 0) return -1;
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            if (parse_int_option(argc, argv, &i, 0, &warmup_s) != 0) return -1;
+        } else if (strcmp(argv[i], "--duration") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &duration_s) != 0) return -1;
+        } else if (strcmp(argv[i], "--steady-state") == 0) {
+            g_ctx.measure.steady_state = 1;
+        } else if (strcmp(argv[i], "--steady-cv") == 0) {
+            if (parse_int_option(argc, argv, &i, 1, &steady_cv) != 0) return -1;
+        } else if (strcmp(argv[i], "--steady-window") == 0) {
+            if (parse_int_option(argc, argv, &i, 2, &g_ctx.measure.steady_window) != 0) return -1;
+            if (g_ctx.measure.steady_window > MEASURE_MAX_WINDOW) {
+                fprintf(stderr, "Error: --steady-window must be at most %d\n", MEASURE_MAX_WINDOW);
+                return -1;
+            }
         } else {
             fprintf(stderr, "Error: Unknown argument '%s'\n", argv[i]);
             return -1;
@@ -107,8 +386,8 @@ int parse_arguments(int argc, char *argv[]) {
     
     // Check required arguments based on mode
     int expected_args = 4; // -t, -m, -i, -p are always required
-    if (!g_ctx.is_server) {
-        expected_args = 5; // Client also needs -d
+    if (!g_ctx.is_server && !g_ctx.udp) {
+        expected_args = 5; // TCP client also needs -d
     }
     
     if (required_args < expected_args) {
@@ -117,8 +396,81 @@ int parse_arguments(int argc, char *argv[]) {
         return -1;
     }
     
+    // Resolve the transport and make sure the address is usable with it
+    if (!g_ctx.transport_set) {
+        g_ctx.transport = transport_detect(g_ctx.listen_ip);
+    }
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    if (transport_build_address(g_ctx.listen_port_start + g_ctx.num_threads - 1, &addr, &addr_len) != 0) {
+        fprintf(stderr, "Error: Invalid %s address '%s'\n", transport_name(g_ctx.transport), g_ctx.listen_ip);
+        return -1;
+    }
+    
+    tuning_resolve();
+    
+    if (g_ctx.udp) {
+        if (!transport_is_ip()) {
+            fprintf(stderr, "Error: --udp requires an inet or inet6 transport\n");
+            return -1;
+        }
+        if (g_ctx.tls_enabled || g_ctx.protocol->framed) {
+            fprintf(stderr, "Error: --udp cannot be combined with --tls or --protocol\n");
+            return -1;
+        }
+        if (g_ctx.tcp_info_every > 0) {
+            fprintf(stderr, "Warning: --tcp-info ignored in UDP mode\n");
+            g_ctx.tcp_info_every = 0;
+        }
+        if (g_ctx.record_path || g_ctx.replay_path) {
+            fprintf(stderr, "Error: --record and --replay are only available for TCP streams\n");
+            return -1;
+        }
+        if (g_ctx.ramp_rate > 0 || ramp_time_s > 0 || g_ctx.pool_size > 0) {
+            fprintf(stderr, "Warning: --ramp-rate, --ramp-time and --pool ignored in UDP mode\n");
+            g_ctx.ramp_rate = 0;
+            ramp_time_s = 0;
+            g_ctx.pool_size = 0;
+        }
+    }
+    
+    if (g_ctx.is_server && (g_ctx.record_path || g_ctx.replay_path)) {
+        fprintf(stderr, "Warning: --record and --replay ignored in server mode\n");
+        g_ctx.record_path = NULL;
+        g_ctx.replay_path = NULL;
+    }
+    if (g_ctx.record_path && g_ctx.replay_path) {
+        fprintf(stderr, "Error: --record and --replay are mutually exclusive\n");
+        return -1;
+    }
+    
+    if (g_ctx.ramp_rate > 0 && ramp_time_s > 0) {
+        fprintf(stderr, "Error: --ramp-rate and --ramp-time are mutually exclusive\n");
+        return -1;
+    }
+    g_ctx.ramp_time_ms = ramp_time_s * 1000;
+    
+    if (request_size > PROTOCOL_MAX_PAYLOAD || response_size > PROTOCOL_MAX_PAYLOAD) {
+        fprintf(stderr, "Error: Request/response size must be at most %d bytes\n", PROTOCOL_MAX_PAYLOAD);
+        return -1;
+    }
+    g_ctx.request_size = (uint32_t)request_size;
+    g_ctx.response_size = (uint32_t)(response_size < 0 ? request_size : response_size);
+    protocol_init();
+    
+    if (warmup_s < 0) {
+        warmup_s = g_ctx.measure.steady_state ? DEFAULT_STEADY_MAX_WARMUP_S : 0;
+    }
+    g_ctx.measure.warmup_ms = (uint64_t)warmup_s * 1000;
+    g_ctx.measure.duration_ms = (uint64_t)duration_s * 1000;
+    g_ctx.measure.steady_cv_percent = steady_cv;
+    
+    if (g_ctx.tcp_info_every > 0 && !transport_is_ip()) {
+        fprintf(stderr, "Warning: --tcp-info ignored, TCP_INFO is only available for inet/inet6 transports\n");
+    }
+    
     // Validate client-specific requirements
-    if (!g_ctx.is_server && g_ctx.data_size_before_reconnect == 0) {
+    if (!g_ctx.is_server && !g_ctx.udp && g_ctx.data_size_before_reconnect == 0) {
         fprintf(stderr, "Error: Client mode requires -d/--data-size parameter\n");
         print_usage(argv[0]);
         return -1;
@@ -145,34 +497,120 @@ int set_socket_nonblocking(int fd) {
 }
 
 int main(int argc, char *argv[]) {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    // Trace conversion is a standalone command
+    if (argc >= 2 && strcmp(argv[1], "--trace-convert") == 0) {
+        if (argc != 4) {
+            fprintf(stderr, "Usage: %s --trace-convert <in> <out>\n", argv[0]);
+            return 1;
+        }
+        return trace_convert(argv[2], argv[3]) == 0 ? 0 : 1;
+    }
     
     // Parse arguments
     if (parse_arguments(argc, argv) != 0) {
         return 1;
     }
     
+    // Set up signal handling and the shutdown eventfd
+    if (shutdown_init() != 0) {
+        return 1;
+    }
+    
+    if (tls_init() != 0) {
+        return 1;
+    }
+    
+    if (g_ctx.replay_path && trace_replay_open(g_ctx.replay_path) != 0) {
+        return 1;
+    }
+    
     g_ctx.running = 1;
     
     printf("Configuration:\n");
     printf("  Mode: %s\n", g_ctx.is_server ? "Server" : "Client");
     printf("  Threads: %d\n", g_ctx.num_threads);
-    printf("  %s IP: %s\n", g_ctx.is_server ? "Listen" : "Connect", g_ctx.listen_ip);
+    printf("  Transport: %s\n", transport_name(g_ctx.transport));
+    printf("  %s Address: %s\n", g_ctx.is_server ? "Listen" : "Connect", g_ctx.listen_ip);
     printf("  Port Range: %d-%d\n", g_ctx.listen_port_start, g_ctx.listen_port_start + g_ctx.num_threads - 1);
+    printf("  Socket Tuning: %s (requested: ", tuning_profile_name(g_ctx.tuning_profile));
+    tuning_print_values(stdout, &g_ctx.tuning);
+    printf(")\n");
+    if (g_ctx.measure.steady_state) {
+        printf("  Warm-up: until throughput CV <= %.0f%% over %d s (max %lu s)\n",
+               g_ctx.measure.steady_cv_percent, g_ctx.measure.steady_window, g_ctx.measure.warmup_ms / 1000);
+    } else if (g_ctx.measure.warmup_ms > 0) {
+        printf("  Warm-up: %lu s\n", g_ctx.measure.warmup_ms / 1000);
+    }
+    if (g_ctx.measure.duration_ms > 0) {
+        printf("  Measurement Duration: %lu s\n", g_ctx.measure.duration_ms / 1000);
+    }
+    if (g_ctx.spin_usec > 0) {
+        printf("  Event Loop: spin, back to blocking after %d us idle\n", g_ctx.spin_usec);
+    }
+    if (tcp_info_enabled()) {
+        printf("  TCP_INFO Sampling: every %d connection(s), %d ms\n", g_ctx.tcp_info_every, g_ctx.tcp_info_interval_ms);
+    }
+    if (g_ctx.udp) {
+        printf("  UDP: batch %d, GSO %s, GRO %s", g_ctx.udp_batch,
+               g_ctx.udp_gso ? "requested" : "off", g_ctx.udp_gro ? "requested" : "off");
+        if (!g_ctx.is_server) {
+            printf(", %d-byte datagrams, window %d", g_ctx.datagram_size, g_ctx.udp_window);
+        }
+        printf("\n");
+    } else {
+        printf("  Protocol: %s\n", g_ctx.protocol->name);
+    }
+    if (g_ctx.is_server && !g_ctx.udp) {
+        printf("  Read Scheduling: %s", sched_name(g_ctx.sched));
+        if (g_ctx.sched != SERVER_SCHED_FIFO) {
+            printf(", %d bytes per visit", g_ctx.conn_budget);
+        }
+        printf("\n");
+    }
+    if (g_ctx.tls_enabled) {
+        printf("  TLS: 1.%d, kTLS offload %s\n", g_ctx.tls_version - 10, g_ctx.tls_ktls ? "requested" : "off");
+    }
+    if (!g_ctx.is_server && g_ctx.protocol->framed) {
+        printf("  Request/Response: %u/%u payload bytes (%lu/%lu on the wire), %lu requests per iteration\n",
+               g_ctx.request_size, g_ctx.response_size, g_ctx.request_wire_size, g_ctx.response_wire_size,
+               g_ctx.iteration_send_bytes / g_ctx.request_wire_size);
+    }
     if (!g_ctx.is_server) {
-        printf("  Data Size Before Reconnect: %lu bytes\n", g_ctx.data_size_before_reconnect);
+        if (!g_ctx.udp) {
+            printf("  Data Size Before Reconnect: %lu bytes\n", g_ctx.data_size_before_reconnect);
+        }
+        if (g_ctx.ramp_rate > 0) {
+            printf("  Connect Ramp: %d per ms\n", g_ctx.ramp_rate);
+        } else if (g_ctx.ramp_time_ms > 0) {
+            printf("  Connect Ramp: linear over %d s\n", g_ctx.ramp_time_ms / 1000);
+        }
+        if (g_ctx.pool_size > 0) {
+            printf("  Connection Pool: %d spare socket(s) per connection\n", g_ctx.pool_size);
+        }
+        if (g_ctx.record_path) {
+            printf("  Record: %s\n", g_ctx.record_path);
+        }
+        if (g_ctx.replay_path) {
+            if (g_ctx.replay_speed > 0) {
+                printf("  Replay: %s at %gx\n", g_ctx.replay_path, g_ctx.replay_speed);
+            } else {
+                printf("  Replay: %s as fast as possible\n", g_ctx.replay_path);
+            }
+        }
         printf("  Stats Refresh: %d seconds\n\n", g_ctx.refresh_stats_seconds);
     }
     
     int result;
+    g_ctx.run_start_ns = now_monotonic_ns();
+    measure_init();
     if (g_ctx.is_server) {
         result = run_server();
     } else {
         result = run_client();
     }
+    g_ctx.run_end_ns = now_monotonic_ns();
     
+    print_final_summary();
     cleanup_resources();
     
     return result;
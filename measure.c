@@ -0,0 +1,127 @@
+#include "network_app.h"
+
+// Warm-up and measurement windows. The event loops call measure_tick() with
+// their running byte total; once per MEASURE_INTERVAL_MS it records the
+// interval throughput and decides when warm-up ends (fixed time, or steady
+// state by coefficient of variation) and when the measurement window is over.
+
+void measure_init(void) {
+    measure_state_t *m = &g_ctx.measure;
+    uint64_t now_ms = now_monotonic_ms();
+
+    m->phase_start_ms = now_ms;
+    m->last_interval_ms = now_ms;
+    m->last_bytes = 0;
+    m->samples = 0;
+    m->last_cv_percent = -1.0;
+    m->phase = (m->warmup_ms > 0 || m->steady_state) ? MEASURE_PHASE_WARMUP : MEASURE_PHASE_MEASURE;
+}
+
+// Coefficient of variation (stddev / mean) of the last window of intervals
+static double measure_window_cv(const measure_state_t *m) {
+    int n = m->steady_window;
+    double mean = 0.0, var = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        mean += m->interval_bytes[i];
+    }
+    mean /= n;
+    if (mean <= 0.0) {
+        return -1.0;
+    }
+    for (int i = 0; i < n; i++) {
+        double d = m->interval_bytes[i] - mean;
+        var += d * d;
+    }
+    return sqrt(var / n) / mean;
+}
+
+static int measure_warmup_done(measure_state_t *m, uint64_t now_ms) {
+    uint64_t elapsed_ms = now_ms - m->phase_start_ms;
+
+    if (!m->steady_state) {
+        return elapsed_ms >= m->warmup_ms;
+    }
+
+    if (m->samples >= m->steady_window) {
+        double cv = measure_window_cv(m);
+        m->last_cv_percent = cv * 100.0;
+        if (cv >= 0.0 && m->last_cv_percent <= m->steady_cv_percent) {
+            printf("MEASURE: steady state after %.1f s (throughput CV %.2f%% over %d intervals)\n",
+                   elapsed_ms / 1000.0, m->last_cv_percent, m->steady_window);
+            return 1;
+        }
+    }
+    // In steady-state mode --warmup is the upper bound
+    if (elapsed_ms >= m->warmup_ms) {
+        printf("MEASURE: steady state not reached within %.1f s (last CV %.2f%%), measuring anyway\n",
+               elapsed_ms / 1000.0, m->last_cv_percent);
+        return 1;
+    }
+    return 0;
+}
+
+int measure_tick(uint64_t total_bytes) {
+    measure_state_t *m = &g_ctx.measure;
+
+    if (m->phase == MEASURE_PHASE_DONE) {
+        return MEASURE_EVENT_NONE;
+    }
+
+    uint64_t now_ms = now_monotonic_ms();
+    if (now_ms - m->last_interval_ms < MEASURE_INTERVAL_MS) {
+        return MEASURE_EVENT_NONE;
+    }
+
+    // Normalise to bytes per interval in case the loop ticked late
+    uint64_t elapsed = now_ms - m->last_interval_ms;
+    double bytes = (double)(total_bytes - m->last_bytes) * MEASURE_INTERVAL_MS / elapsed;
+    m->interval_bytes[m->samples % m->steady_window] = bytes;
+    m->samples++;
+    m->last_interval_ms = now_ms;
+    m->last_bytes = total_bytes;
+
+    if (m->phase == MEASURE_PHASE_WARMUP) {
+        if (!measure_warmup_done(m, now_ms)) {
+            return MEASURE_EVENT_NONE;
+        }
+        m->phase = MEASURE_PHASE_MEASURE;
+        m->phase_start_ms = now_ms;
+        return MEASURE_EVENT_STARTED;
+    }
+
+    if (m->duration_ms > 0 && now_ms - m->phase_start_ms >= m->duration_ms) {
+        m->phase = MEASURE_PHASE_DONE;
+        return MEASURE_EVENT_ENDED;
+    }
+    return MEASURE_EVENT_NONE;
+}
+
+int measure_active(void) {
+    return g_ctx.measure.warmup_ms > 0 || g_ctx.measure.duration_ms > 0 || g_ctx.measure.steady_state;
+}
+
+void measure_format_phase(char *buf, size_t len) {
+    const measure_state_t *m = &g_ctx.measure;
+    uint64_t elapsed_s = (now_monotonic_ms() - m->phase_start_ms) / 1000;
+
+    switch (m->phase) {
+        case MEASURE_PHASE_WARMUP:
+            if (m->steady_state && m->last_cv_percent >= 0.0) {
+                snprintf(buf, len, "warm-up %lus, CV %.1f%%", elapsed_s, m->last_cv_percent);
+            } else {
+                snprintf(buf, len, "warm-up %lus", elapsed_s);
+            }
+            break;
+        case MEASURE_PHASE_MEASURE:
+            if (m->duration_ms > 0) {
+                snprintf(buf, len, "measuring %lu/%lus", elapsed_s, m->duration_ms / 1000);
+            } else {
+                snprintf(buf, len, "measuring %lus", elapsed_s);
+            }
+            break;
+        default:
+            snprintf(buf, len, "done");
+            break;
+    }
+}
@@ -1,6 +1,9 @@
 #ifndef NETWORK_APP_H
 #define NETWORK_APP_H
 
+// Linux socket extensions (TCP_QUICKACK, SO_BUSY_POLL, ...)
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,27 +11,359 @@
 #include <pthread.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <time.h>
 #include <signal.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <stddef.h>
+#include <math.h>
 
 #define MAX_EVENTS 1024
 #define BUFFER_SIZE 4096
 #define MAX_THREADS 100
-#define MAX_CONNECTIONS_PER_THREAD 1000
+#define MAX_CONNECTIONS_PER_THREAD 1000  // Default for --max-conns
+#define SLAB_CHUNK_CONNECTIONS 64        // Connection slots allocated at a time (see slab.c)
+#define MAX_ADDRESS_LEN 108  // Large enough for IPv6 literals and sun_path
+#define DEFAULT_DRAIN_TIMEOUT_MS 1000
+#define MAX_POOL_SIZE 64  // Pre-connected spare sockets per client connection
+#define DEFAULT_CONN_BUDGET 16384  // Bytes a connection may read per scheduler visit
+
+// Protocol framing (see protocol.c)
+#define PROTOCOL_HEADER_SIZE 8
+#define PROTOCOL_MAX_PAYLOAD (16 * 1024 * 1024)
+#define PROTOCOL_FILL_SIZE 65536
+#define PROTOCOL_MAX_IOV 64
+#define DEFAULT_REQUEST_SIZE 64
+
+// Largest TLS record payload; reading at least this much per SSL_read()
+// leaves nothing buffered inside OpenSSL
+#define TLS_RECORD_SIZE 16384
+
+// UDP echo mode (see udp.c)
+#define UDP_HEADER_SIZE 16           // Sequence number + client send timestamp
+#define UDP_MAX_DATAGRAM 65507
+#define UDP_MAX_BATCH 256            // Messages per recvmmsg()/sendmmsg()
+#define UDP_MAX_SEGMENTS 64          // Kernel limit on GSO segments per send
+#define UDP_RX_BUFFER_SIZE 65536     // Room for one GRO-coalesced receive
+#define UDP_LOSS_TIMEOUT_MS 200      // Unanswered datagrams after this are lost
+#define DEFAULT_DATAGRAM_SIZE 1024
+#define DEFAULT_UDP_BATCH 32
+#define DEFAULT_UDP_WINDOW 64
+
+// Workload traces (see trace.c)
+#define TRACE_MAGIC "NATRACE1"
+#define TRACE_VERSION 1
+#define TRACE_RECORD_BUFFER 4096  // Records buffered before each write while recording
+
+// Warm-up / measurement windows (see measure.c)
+#define MEASURE_INTERVAL_MS 1000
+#define MEASURE_MAX_WINDOW 60
+#define DEFAULT_STEADY_WINDOW 5
+#define DEFAULT_STEADY_CV_PERCENT 5
+#define DEFAULT_STEADY_MAX_WARMUP_S 30
+
+// Latency histogram geometry (see histogram.c)
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+// Transport families selectable with -x/--transport
+typedef enum {
+    TRANSPORT_INET = 0,
+    TRANSPORT_INET6,
+    TRANSPORT_UNIX
+} transport_t;
+
+// Socket tuning profiles selectable with --tuning
+typedef enum {
+    TUNING_PROFILE_DEFAULT = 0,
+    TUNING_PROFILE_LATENCY,
+    TUNING_PROFILE_THROUGHPUT,
+    TUNING_PROFILE_CUSTOM
+} tuning_profile_t;
+
+// Server read scheduling policies selectable with --sched (see sched.c)
+typedef enum {
+    SERVER_SCHED_FIFO = 0,   // One read per event, in epoll order
+    SERVER_SCHED_RR,         // Run queue, up to --conn-budget bytes per visit
+    SERVER_SCHED_DRR         // Run queue, deficit round robin with --conn-budget quantum
+} server_sched_t;
 
-// Socket metadata for accepted connections
+// Socket roles a tuning profile is applied to
+typedef enum {
+    TUNING_ROLE_LISTENER = 0,
+    TUNING_ROLE_ACCEPTED,
+    TUNING_ROLE_CLIENT,
+    TUNING_ROLE_COUNT
+} tuning_role_t;
+
+// Socket option values (-1 = leave the kernel default)
 typedef struct {
-    int socket_fd;
+    int nodelay;         // TCP_NODELAY
+    int quickack;        // TCP_QUICKACK, re-armed after every read
+    int busy_poll_usec;  // SO_BUSY_POLL
+    int sndbuf;          // SO_SNDBUF
+    int rcvbuf;          // SO_RCVBUF
+    int notsent_lowat;   // TCP_NOTSENT_LOWAT
+    int cork;            // TCP_CORK, released after each write batch
+    int prefer_busy_poll;  // SO_PREFER_BUSY_POLL
+} socket_tuning_t;
+
+// Log-linear histogram of nanosecond latencies
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+} latency_histogram_t;
+
+// Trace file layout: one header, then fixed-size records in time order,
+// all in host byte order
+typedef struct {
+    char magic[8];           // TRACE_MAGIC
+    uint32_t version;        // TRACE_VERSION
+    uint32_t connections;    // Highest connection index + 1
+} trace_header_t;
+
+typedef struct {
+    uint64_t time_ns;        // Offset from the start of the trace
+    uint32_t connection;     // Client connection index
+    uint32_t size;           // Bytes sent
+} trace_record_t;
+
+// A complete message parsed in place from a receive buffer
+typedef struct {
+    const char *frame;         // Start of the frame (header included)
+    const char *payload;
+    uint32_t payload_length;
+    uint32_t response_length;  // Response payload size requested by the client
+} protocol_frame_t;
+
+// Response to one frame: an optional header, then body_length bytes taken
+// cyclically from body (body_chunk bytes long), so large generated bodies
+// need no buffer of their own
+typedef struct {
+    char header[PROTOCOL_HEADER_SIZE];
+    size_t header_length;
+    const char *body;
+    size_t body_length;
+    size_t body_chunk;
+} protocol_response_t;
+
+// Protocol plug-in interface
+typedef struct {
+    const char *name;
+    int framed;   // 0 = raw byte stream echo
+    // Returns the frame size when complete, 0 if more bytes are needed, -1 if malformed
+    long (*parse)(const char *buf, size_t len, protocol_frame_t *frame);
+    void (*respond)(const protocol_frame_t *frame, protocol_response_t *resp);
+} protocol_ops_t;
+
+// Client-side response parser state
+typedef struct {
+    char header[PROTOCOL_HEADER_SIZE];
+    size_t header_have;
+    uint64_t body_remaining;
+} protocol_rx_state_t;
+
+typedef enum {
+    TLS_STATE_NONE = 0,
+    TLS_STATE_HANDSHAKE,
+    TLS_STATE_ESTABLISHED
+} tls_state_t;
+
+// Result of one nonblocking handshake step
+typedef enum {
+    TLS_IO_DONE = 0,
+    TLS_IO_WANT_READ,
+    TLS_IO_WANT_WRITE,
+    TLS_IO_ERROR,
+    TLS_IO_CLOSED    // Peer closed before sending anything (e.g. an unused pool spare)
+} tls_io_t;
+
+// Per-connection TLS session
+typedef struct {
+    void *ssl;                    // SSL *, NULL for plaintext connections
+    int state;                    // tls_state_t
+    int ktls_tx;                  // Kernel TLS encrypts writes: plain write() works
+    int ktls_rx;                  // Kernel TLS decrypts reads: plain read() works
+    uint64_t handshake_start_ns;
+} tls_conn_t;
+
+// Process-wide TLS counters (updated atomically by server threads)
+typedef struct {
+    uint64_t handshakes;
+    uint64_t handshake_failures;
+    uint64_t ktls_tx;
+    uint64_t ktls_rx;
+} tls_stats_t;
+
+typedef enum {
+    MEASURE_PHASE_WARMUP = 0,
+    MEASURE_PHASE_MEASURE,
+    MEASURE_PHASE_DONE
+} measure_phase_t;
+
+// Returned by measure_tick() on phase transitions
+typedef enum {
+    MEASURE_EVENT_NONE = 0,
+    MEASURE_EVENT_STARTED,   // Warm-up over: reset or snapshot counters
+    MEASURE_EVENT_ENDED      // Measurement window over: start shutdown
+} measure_event_t;
+
+// Warm-up and measurement window state
+typedef struct {
+    // Configuration
+    uint64_t warmup_ms;            // Fixed warm-up, or upper bound in steady-state mode
+    uint64_t duration_ms;          // Measurement window (0 = until signalled)
+    int steady_state;              // Detect the end of warm-up automatically
+    double steady_cv_percent;      // Max coefficient of variation of interval throughput
+    int steady_window;             // Number of intervals the CV is computed over
+    
+    // Runtime
+    int phase;                     // measure_phase_t
+    uint64_t phase_start_ms;
+    uint64_t last_interval_ms;
+    uint64_t last_bytes;
+    double interval_bytes[MEASURE_MAX_WINDOW];  // Ring of per-interval throughput
+    int samples;
+    double last_cv_percent;
+} measure_state_t;
+
+// Server totals summed across threads
+typedef struct {
+    uint64_t accepts;
     uint64_t bytes_received;
     uint64_t bytes_sent;
-    uint64_t bytes_pending_send;  // Bytes received but not yet fully sent back
+    uint64_t frames;
+    uint64_t recv_calls;
+    uint64_t tx_drops;
+} server_totals_t;
+
+// Client-side UDP flow state. Sequence numbers start at 1; everything above
+// highest_seq that was sent is in flight, bounded by --udp-window.
+typedef struct {
+    uint64_t next_seq;
+    uint64_t highest_seq;        // Highest sequence number echoed back
+    uint64_t last_progress_ns;   // Last echo, or send into an empty window
+    uint64_t packets_sent;
+    uint64_t packets_received;
+    uint64_t packets_lost;       // Gaps below highest_seq plus timed-out tails
+    uint64_t packets_reordered;  // Echoes that arrived below highest_seq
+    uint64_t rtt_sum_ns;
+    int blocked;                 // Send buffer full, waiting for EPOLLOUT
+} udp_flow_t;
+
+// One getsockopt(TCP_INFO) sample for a connection
+typedef struct {
+    uint32_t rtt_us;         // Smoothed RTT
+    uint32_t rttvar_us;
+    uint32_t snd_cwnd;       // Congestion window in segments
+    uint32_t total_retrans;  // Retransmitted segments over the connection lifetime
+    uint32_t unacked_bytes;  // Unacknowledged segments * MSS
+    int valid;
+} tcp_info_sample_t;
+
+// min/avg/max accumulator for one TCP_INFO field
+typedef struct {
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t count;
+} tcp_info_stat_t;
+
+// TCP_INFO aggregates across the sampled connections
+typedef struct {
+    tcp_info_stat_t rtt_us;
+    tcp_info_stat_t snd_cwnd;
+    tcp_info_stat_t total_retrans;
+    tcp_info_stat_t unacked_bytes;
+} tcp_info_agg_t;
+
+// Response the socket would not take in full, parked until EPOLLOUT
+typedef struct {
+    protocol_response_t resp;     // Raw echoes point body at data, framed ones at rx_buffer
+    size_t done;                  // Bytes of resp already written
+    char data[BUFFER_SIZE];       // Raw: copy of the unsent echo
+} pending_tx_t;
+
+// Hot per-connection state for accepted connections, touched on every event
+typedef struct {
+    int socket_fd;
     int is_active;
+    int queued;                   // In the thread's run queue
+    int tx_blocked;               // tx holds an unsent response; reads wait for it
+    pending_tx_t *tx;             // Allocated on the first short write
+    int64_t deficit;              // DRR: credit carried over while the connection stays backlogged
+    uint64_t ready_ns;            // Became ready (queued, or reported by epoll)
+    char *rx_buffer;              // Framed: a partial frame between reads (drr: plus frames owed credit)
+    size_t rx_length;
+    size_t rx_offset;             // Framed: first byte not yet answered
+    size_t rx_capacity;
+    tls_conn_t tls;
 } accepted_socket_meta_t;
 
+// Cold per-connection statistics, kept out of the event path's cache lines
+typedef struct {
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+    uint64_t accepted_ns;         // For the per-connection throughput in the fairness index
+    tcp_info_sample_t tcp_info;   // Latest sample, if this slot is sampled
+} accepted_socket_stats_t;
+
+// Growable per-thread connection slab of fixed-size chunks (see slab.c).
+// Connections are addressed by slot index, which is also their epoll data.
+typedef struct {
+    accepted_socket_meta_t **hot;     // Chunk pointers
+    accepted_socket_stats_t **cold;
+    int chunk_count;
+    int chunk_slots;                  // Capacity of the chunk pointer arrays
+    int *free_slots;                  // Stack of released slots
+    int free_count;
+    int used;                         // Slots handed out so far (peak)
+    int max_slots;
+} conn_slab_t;
+
+// Ring of connection slots waiting for service (see sched.c)
+typedef struct {
+    int *slots;
+    int head;
+    int count;
+    int capacity;
+} run_queue_t;
+
+// Running sums for Jain's fairness index (sum x)^2 / (n * sum x^2)
+typedef struct {
+    double sum;
+    double sum_sq;
+    uint64_t count;
+} fairness_t;
+
+// Event loop pass counts and time split, plus the --spin state (see loop.c)
+typedef struct {
+    uint64_t iterations;      // Loop passes (loop_wait() calls)
+    uint64_t busy;            // Passes that returned events
+    uint64_t polls;           // epoll_wait() calls with a zero timeout
+    uint64_t blocks;          // epoll_wait() calls that could sleep
+    uint64_t fallbacks;       // Spins that went idle and fell back to sleeping
+    uint64_t busy_ns;         // Between waits, handling events
+    uint64_t spin_ns;         // Polling epoll without sleeping
+    uint64_t block_ns;        // Asleep in epoll_wait()
+    uint64_t mark_ns;         // Last time a wait returned
+    int spinning;             // Last wait returned events: spin on the next one
+} loop_stats_t;
+
 // Metadata for server listen sockets
 typedef struct {
     int listen_fd;
@@ -38,8 +373,26 @@ typedef struct {
     uint64_t total_accepts;
     uint64_t total_bytes_received;  // Overall total across all connections
     uint64_t total_bytes_sent;      // Overall total across all connections
-    accepted_socket_meta_t accepted_sockets[MAX_CONNECTIONS_PER_THREAD];
+    uint64_t total_frames;          // Framed protocols: requests answered; UDP: datagrams echoed
+    uint64_t total_recv_calls;      // UDP: recvmmsg() calls that returned data
+    uint64_t total_tx_drops;        // UDP: echo messages dropped on a full send buffer
+    int udp_gro;                    // UDP: GRO/GSO on this thread's socket (copies
+    int udp_gso;                    // of the probed g_ctx flags)
+    uint64_t drained_connections;   // Closed by their peer during shutdown drain
+    uint64_t forced_connections;    // Still open when the drain deadline expired
+    conn_slab_t conns;
     int active_connections;
+    int peak_slots;                 // Connection slots allocated at exit
+    size_t slab_bytes;              // Connection state footprint at exit
+    uint64_t last_tcp_info_ms;      // Last TCP_INFO sampling pass
+    tcp_info_agg_t tcp_info_agg;    // Aggregate of the last sampling pass
+    run_queue_t runq;               // --sched rr/drr: connections with data left to read
+    int parked_connections;         // Connections with a parked (unsent) response
+    latency_histogram_t sched_wait;     // Ready to served, per visit
+    latency_histogram_t sched_service;  // Time one visit held the thread
+    fairness_t fairness;            // Per-connection throughput of closed connections
+    int stats_epoch;                // Last g_ctx.server_stats_epoch seen
+    loop_stats_t loop;              // Event loop passes and time split
     pthread_t thread_id;
 } server_thread_meta_t;
 
@@ -54,6 +407,19 @@ typedef struct {
     uint64_t current_iteration_sent;     // Bytes sent in current iteration
     uint64_t current_iteration_received; // Bytes received in current iteration
     int is_connected;
+    uint64_t iteration_start_ns;         // connect() time of the current iteration
+    uint64_t total_responses;            // Framed protocols: complete responses received
+    protocol_rx_state_t rx_state;
+    tls_conn_t tls;
+    tcp_info_sample_t tcp_info;          // Latest sample, if this connection is sampled
+    udp_flow_t udp;
+    int *pool_fds;                       // Ring of --pool spare sockets, oldest at pool_head
+    int pool_head;
+    int pool_count;
+    uint64_t pool_hits;                  // Iterations started on a spare socket
+    uint64_t cold_connects;              // Iterations that had to connect() first
+    uint64_t replay_credit;              // --replay: bytes released by the trace, not yet sent
+    int want_write;                      // EPOLLOUT is in the epoll interest
 } client_connection_meta_t;
 
 // Global context structure
@@ -61,7 +427,45 @@ typedef struct {
     // Input parameters
     int num_threads;
     int is_server;
-    char listen_ip[16];
+    char listen_ip[MAX_ADDRESS_LEN];  // IP address or Unix socket path ('@' = abstract)
+    int transport;                    // transport_t, explicit or detected from listen_ip
+    int transport_set;
+    int tuning_profile;                 // tuning_profile_t
+    socket_tuning_t tuning_override;    // Individual options given on the command line
+    socket_tuning_t tuning;             // Resolved profile + overrides
+    socket_tuning_t tuning_effective[TUNING_ROLE_COUNT]; // Values read back from the kernel
+    volatile int tuning_reported[TUNING_ROLE_COUNT];
+    int tcp_info_every;                 // Sample every Nth connection (0 = off)
+    int tcp_info_interval_ms;           // Sampling period
+    int drain_timeout_ms;               // Shutdown drain deadline
+    const protocol_ops_t *protocol;
+    uint32_t request_size;              // Request payload bytes (framed protocols)
+    uint32_t response_size;             // Response payload bytes (framed protocols)
+    uint64_t request_wire_size;         // Header + payload
+    uint64_t response_wire_size;
+    uint64_t iteration_send_bytes;      // Per iteration, rounded up to whole requests
+    uint64_t iteration_recv_bytes;
+    int tls_enabled;
+    int tls_version;                    // 12 or 13
+    int tls_ktls;                       // Try to offload established sessions to kernel TLS
+    tls_stats_t tls_stats;
+    tls_stats_t tls_baseline;           // Server counters at the end of warm-up
+    int udp;                            // Datagram echo instead of TCP streams
+    int datagram_size;                  // Client datagram size, header included
+    int udp_batch;                      // Messages per recvmmsg()/sendmmsg()
+    int udp_window;                     // Client datagrams in flight per socket
+    int udp_gso;                        // Send with UDP_SEGMENT
+    int udp_gro;                        // Receive with UDP_GRO
+    int max_connections;                // Connection slots per server thread
+    int sched;                          // server_sched_t
+    int conn_budget;                    // Bytes per connection per scheduler visit (DRR quantum)
+    int ramp_rate;                      // Client startup connects per millisecond (0 = all at once)
+    int ramp_time_ms;                   // Or spread startup connects over this long
+    int pool_size;                      // Pre-connected spare sockets per client connection
+    const char *record_path;            // --record: write the client's sends as a trace
+    const char *replay_path;            // --replay: send what a trace says, when it says
+    double replay_speed;                // Trace time divisor (0 = as fast as possible)
+    int spin_usec;                      // --spin: poll epoll for this long after events (0 = off)
     int listen_port_start;
     uint64_t data_size_before_reconnect;
     int refresh_stats_seconds;
@@ -77,10 +481,23 @@ typedef struct {
     
     // Client specific
     client_connection_meta_t *client_connections;
+    int *client_pool_fds;                // Backing store for every connection's pool ring
     int client_epoll_fd;
+    latency_histogram_t client_latency;  // connect() to full echo, per iteration
+    latency_histogram_t client_handshake_latency;  // connect() to TLS handshake done
+    loop_stats_t client_loop;            // Event loop passes and time split
+    
+    // Run timing for the final summary
+    uint64_t run_start_ns;               // Process start, or end of warm-up
+    uint64_t run_end_ns;
+    measure_state_t measure;
+    server_totals_t server_baseline;     // Server totals at the end of warm-up
+    volatile int server_stats_epoch;     // Bumped at the end of warm-up; threads reset their scheduler stats
     
     // Control flags
-    volatile int running;
+    volatile int running;                          // Cleared to stop immediately (second signal)
+    volatile sig_atomic_t shutdown_requested;      // Set to start a graceful drain
+    int shutdown_fd;                               // eventfd polled by every event loop
 } global_ctx_t;
 
 // Global context variable
@@ -92,10 +509,131 @@ int parse_arguments(int argc, char *argv[]);
 int set_socket_nonblocking(int fd);
 void *server_thread_func(void *arg);
 int run_server(void);
+void server_collect_totals(server_totals_t *totals);
 int run_client(void);
 void print_statistics(void);
 void signal_handler(int sig);
+int shutdown_init(void);
+void request_shutdown(void);
+void print_final_summary(void);
 void cleanup_resources(void);
 void count_socket_error(int error_code);
+uint64_t now_monotonic_ns(void);
+uint64_t now_monotonic_ms(void);
+void print_rate_line(const char *label, uint64_t bytes, double seconds);
+
+// Transport abstraction (transport.c)
+int transport_parse(const char *name);
+int transport_detect(const char *address);
+const char *transport_name(int transport);
+int transport_family(void);
+int transport_is_ip(void);
+int transport_build_address(int port, struct sockaddr_storage *addr, socklen_t *addr_len);
+int transport_create_socket(int sock_type);
+void transport_format_endpoint(int port, char *buf, size_t len);
+void transport_unlink(int port);
+
+// Socket tuning profiles (tuning.c)
+void tuning_init_overrides(void);
+int tuning_parse_profile(const char *name);
+const char *tuning_profile_name(int profile);
+void tuning_resolve(void);
+void tuning_apply(int fd, tuning_role_t role);
+void tuning_rearm_quickack(int fd);
+void tuning_cork(int fd, int on);
+void tuning_nodelay(int fd, int on);
+void tuning_report(int fd, tuning_role_t role);
+void tuning_print_values(FILE *out, const socket_tuning_t *t);
+
+// Protocol plug-ins (protocol.c)
+const protocol_ops_t *protocol_find(const char *name);
+const protocol_ops_t *protocol_default(void);
+void protocol_init(void);
+size_t protocol_build_requests(char *buf, size_t cap);
+uint64_t protocol_expected_response_bytes(uint64_t bytes_sent);
+uint64_t protocol_outstanding_request_bytes(uint64_t bytes_sent, uint64_t bytes_received);
+int protocol_consume_responses(protocol_rx_state_t *st, const char *buf, size_t len);
+
+// TLS with kernel TLS offload (tls.c)
+int tls_init(void);
+void tls_cleanup(void);
+int tls_conn_start(tls_conn_t *t, int fd);
+int tls_conn_handshake(tls_conn_t *t);
+ssize_t tls_conn_read(tls_conn_t *t, int fd, void *buf, size_t len);
+ssize_t tls_conn_write(tls_conn_t *t, int fd, const void *buf, size_t len);
+ssize_t tls_conn_writev(tls_conn_t *t, int fd, const struct iovec *iov, int iovcnt);
+int tls_conn_pending(const tls_conn_t *t);
+void tls_conn_free(tls_conn_t *t);
+void tls_print_summary(void);
+
+// Connection slab functions
+void slab_init(conn_slab_t *slab, int max_slots);
+int slab_alloc(conn_slab_t *slab);
+void slab_free(conn_slab_t *slab, int slot);
+accepted_socket_meta_t *slab_hot(conn_slab_t *slab, int slot);
+accepted_socket_stats_t *slab_cold(conn_slab_t *slab, int slot);
+size_t slab_bytes(const conn_slab_t *slab);
+void slab_destroy(conn_slab_t *slab);
+void slab_print_footprint(void);
+
+// Server read scheduling (sched.c)
+int sched_parse(const char *name);
+const char *sched_name(int sched);
+void runq_push(run_queue_t *q, int slot);
+int runq_pop(run_queue_t *q);
+void runq_destroy(run_queue_t *q);
+void fairness_add(fairness_t *f, double x);
+void fairness_merge(fairness_t *dst, const fairness_t *src);
+double fairness_jain(const fairness_t *f);
+void sched_print_summary(void);
+
+// Event loop waits (loop.c)
+int loop_wait(loop_stats_t *ls, int epoll_fd, struct epoll_event *events, int max_events, int timeout_ms);
+void loop_stats_reset(loop_stats_t *ls);
+void loop_stats_merge(loop_stats_t *dst, const loop_stats_t *src);
+void loop_print_summary(void);
+void loop_print_interval(const char *label, loop_stats_t *prev);
+
+// Workload traces (trace.c)
+int trace_convert(const char *in_path, const char *out_path);
+int trace_record_open(const char *path);
+void trace_record_add(int connection, uint32_t size);
+void trace_record_close(void);
+int trace_replay_open(const char *path);
+void trace_replay_start(void);
+int trace_replay_release(void);
+int trace_replay_timeout_ms(int max_ms);
+int trace_replay_done(void);
+uint32_t trace_replay_connections(void);
+void trace_replay_close(void);
+void trace_print_summary(void);
+
+// UDP echo mode functions
+void udp_probe_offloads(void);
+void *udp_server_thread_func(void *arg);
+int run_udp_client(void);
+void udp_print_summary(double seconds);
+
+// Warm-up and measurement windows (measure.c)
+void measure_init(void);
+int measure_tick(uint64_t total_bytes);
+int measure_active(void);
+void measure_format_phase(char *buf, size_t len);
+
+// Latency histograms (histogram.c)
+void histogram_reset(latency_histogram_t *h);
+void histogram_record(latency_histogram_t *h, uint64_t value);
+void histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src);
+uint64_t histogram_percentile(const latency_histogram_t *h, double percentile);
+void histogram_print(const char *label, const latency_histogram_t *h);
+
+// TCP_INFO sampling (tcpinfo.c)
+int tcp_info_enabled(void);
+int tcp_info_should_sample(int index);
+int tcp_info_sample(int fd, tcp_info_sample_t *out);
+void tcp_info_agg_reset(tcp_info_agg_t *agg);
+void tcp_info_agg_add(tcp_info_agg_t *agg, const tcp_info_sample_t *sample);
+void tcp_info_agg_merge(tcp_info_agg_t *dst, const tcp_info_agg_t *src);
+void tcp_info_print_agg(const char *label, const tcp_info_agg_t *agg);
 
 #endif // NETWORK_APP_H 
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "network_app.h"
+
+// Protocol plug-ins. A protocol defines how the server splits the byte
+// stream into messages (parse) and what it sends back for each one
+// (respond), and how the client builds requests. Frames are parsed in place
+// from the receive buffer: a parsed frame and an echo response both point
+// into that buffer, so nothing is copied between read() and writev().
+//
+// Framed protocols share one wire format, an 8-byte header followed by the
+// payload:
+//   uint32_t payload_length;   (network byte order)
+//   uint32_t response_length;  (payload bytes requested back, reqresp only)
+
+// Pattern used for generated response bodies; writers cycle over it
+static char protocol_fill[PROTOCOL_FILL_SIZE];
+
+static void protocol_put_header(char *buf, uint32_t payload_length, uint32_t response_length) {
+    uint32_t be_length = htonl(payload_length);
+    uint32_t be_response = htonl(response_length);
+    memcpy(buf, &be_length, sizeof(be_length));
+    memcpy(buf + 4, &be_response, sizeof(be_response));
+}
+
+static void protocol_get_header(const char *buf, uint32_t *payload_length, uint32_t *response_length) {
+    uint32_t be_length, be_response;
+    memcpy(&be_length, buf, sizeof(be_length));
+    memcpy(&be_response, buf + 4, sizeof(be_response));
+    *payload_length = ntohl(be_length);
+    *response_length = ntohl(be_response);
+}
+
+// Length-prefixed framing: returns the frame size once it is complete,
+// 0 if more bytes are needed, -1 if the header is invalid
+static long framed_parse(const char *buf, size_t len, protocol_frame_t *frame) {
+    if (len < PROTOCOL_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint32_t payload_length, response_length;
+    protocol_get_header(buf, &payload_length, &response_length);
+    if (payload_length > PROTOCOL_MAX_PAYLOAD || response_length > PROTOCOL_MAX_PAYLOAD) {
+        return -1;
+    }
+    if (len < PROTOCOL_HEADER_SIZE + (size_t)payload_length) {
+        return 0;
+    }
+
+    frame->frame = buf;
+    frame->payload = buf + PROTOCOL_HEADER_SIZE;
+    frame->payload_length = payload_length;
+    frame->response_length = response_length;
+    return PROTOCOL_HEADER_SIZE + (long)payload_length;
+}
+
+// "framed": echo each frame back unchanged, straight out of the receive buffer
+static void framed_echo_respond(const protocol_frame_t *frame, protocol_response_t *resp) {
+    resp->header_length = 0;
+    resp->body = frame->frame;
+    resp->body_length = PROTOCOL_HEADER_SIZE + frame->payload_length;
+    resp->body_chunk = resp->body_length;
+}
+
+// "reqresp": answer an N-byte request with the M bytes it asked for
+static void reqresp_respond(const protocol_frame_t *frame, protocol_response_t *resp) {
+    protocol_put_header(resp->header, frame->response_length, 0);
+    resp->header_length = PROTOCOL_HEADER_SIZE;
+    resp->body = protocol_fill;
+    resp->body_length = frame->response_length;
+    resp->body_chunk = sizeof(protocol_fill);
+}
+
+static const protocol_ops_t protocols[] = {
+    { "raw",     0, NULL,         NULL },
+    { "framed",  1, framed_parse, framed_echo_respond },
+    { "reqresp", 1, framed_parse, reqresp_respond },
+};
+
+const protocol_ops_t *protocol_find(const char *name) {
+    for (size_t i = 0; i < sizeof(protocols) / sizeof(protocols[0]); i++) {
+        if (strcmp(protocols[i].name, name) == 0) {
+            return &protocols[i];
+        }
+    }
+    return NULL;
+}
+
+const protocol_ops_t *protocol_default(void) {
+    return &protocols[0];
+}
+
+void protocol_init(void) {
+    memset(protocol_fill, 0x55, sizeof(protocol_fill));
+
+    const protocol_ops_t *proto = g_ctx.protocol;
+    if (!proto->framed) {
+        g_ctx.request_wire_size = 0;
+        g_ctx.response_wire_size = 0;
+        g_ctx.iteration_send_bytes = g_ctx.data_size_before_reconnect;
+        g_ctx.iteration_recv_bytes = g_ctx.data_size_before_reconnect;
+        return;
+    }
+
+    // The echo protocol answers with the request itself
+    if (proto->respond == framed_echo_respond) {
+        g_ctx.response_size = g_ctx.request_size;
+    }
+    g_ctx.request_wire_size = PROTOCOL_HEADER_SIZE + g_ctx.request_size;
+    g_ctx.response_wire_size = PROTOCOL_HEADER_SIZE + g_ctx.response_size;
+
+    // Iterations are rounded up to whole requests
+    uint64_t requests = (g_ctx.data_size_before_reconnect + g_ctx.request_wire_size - 1) / g_ctx.request_wire_size;
+    g_ctx.iteration_send_bytes = requests * g_ctx.request_wire_size;
+    g_ctx.iteration_recv_bytes = requests * g_ctx.response_wire_size;
+}
+
+size_t protocol_build_requests(char *buf, size_t cap) {
+    size_t wire = g_ctx.request_wire_size;
+    size_t count = cap / wire;
+
+    for (size_t i = 0; i < count; i++) {
+        char *req = buf + i * wire;
+        protocol_put_header(req, g_ctx.request_size, g_ctx.response_size);
+        memset(req + PROTOCOL_HEADER_SIZE, 0xAA, g_ctx.request_size);
+    }
+    return count * wire;
+}
+
+uint64_t protocol_expected_response_bytes(uint64_t bytes_sent) {
+    if (!g_ctx.protocol->framed) {
+        return bytes_sent;
+    }
+    // Only complete requests are answered
+    return bytes_sent / g_ctx.request_wire_size * g_ctx.response_wire_size;
+}
+
+uint64_t protocol_outstanding_request_bytes(uint64_t bytes_sent, uint64_t bytes_received) {
+    uint64_t answered = bytes_received;
+    if (g_ctx.protocol->framed) {
+        // Whole requests whose response has arrived completely
+        answered = bytes_received / g_ctx.response_wire_size * g_ctx.request_wire_size;
+    }
+    return bytes_sent > answered ? bytes_sent - answered : 0;
+}
+
+int protocol_consume_responses(protocol_rx_state_t *st, const char *buf, size_t len) {
+    int responses = 0;
+
+    // Stream parser: only the 8-byte header is ever copied (when it is split
+    // across reads); payload bytes are skipped in place
+    while (len > 0) {
+        if (st->body_remaining > 0) {
+            size_t skip = len < st->body_remaining ? len : (size_t)st->body_remaining;
+            st->body_remaining -= skip;
+            buf += skip;
+            len -= skip;
+            if (st->body_remaining == 0) {
+                responses++;
+            }
+            continue;
+        }
+
+        size_t need = PROTOCOL_HEADER_SIZE - st->header_have;
+        size_t take = len < need ? len : need;
+        memcpy(st->header + st->header_have, buf, take);
+        st->header_have += take;
+        buf += take;
+        len -= take;
+        if (st->header_have < PROTOCOL_HEADER_SIZE) {
+            break;
+        }
+
+        uint32_t payload_length, response_length;
+        protocol_get_header(st->header, &payload_length, &response_length);
+        st->header_have = 0;
+        if (payload_length != g_ctx.response_size) {
+            return -1;
+        }
+        st->body_remaining = payload_length;
+        if (payload_length == 0) {
+            responses++;
+        }
+    }
+    return responses;
+}
@@ -0,0 +1,110 @@
+#include "network_app.h"
+
+// Server read scheduling. With --sched fifo each epoll event gets one read,
+// in the order epoll_wait() returns them. With rr and drr, readable
+// connections join a per-thread run queue that is served in rounds, each
+// connection reading up to --conn-budget bytes per visit before it goes to
+// the back of the queue:
+//   rr   reads are cut to the remaining budget; unused budget is dropped
+//   drr  each turn adds the budget to the connection's deficit. Framed
+//        protocols charge whole requests: a frame is answered only once
+//        the deficit covers its size, so frames are never split across
+//        turns and credit too small for the next one carries over. Raw
+//        echo has no frames, so reads are cut to the deficit and drr only
+//        differs from rr by keeping the credit a parked response left.
+// A connection that runs dry leaves the queue with its deficit reset, so
+// idle connections cannot bank credit.
+
+static const char *sched_names[] = { "fifo", "rr", "drr" };
+
+int sched_parse(const char *name) {
+    for (int i = 0; i < (int)(sizeof(sched_names) / sizeof(sched_names[0])); i++) {
+        if (strcmp(name, sched_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *sched_name(int sched) {
+    return sched_names[sched];
+}
+
+void runq_push(run_queue_t *q, int slot) {
+    if (q->count == q->capacity) {
+        int capacity = q->capacity ? q->capacity * 2 : 64;
+        int *slots = malloc(capacity * sizeof(*slots));
+        if (!slots) {
+            perror("malloc");
+            exit(1);
+        }
+        // Unwrap the ring into the new array
+        for (int i = 0; i < q->count; i++) {
+            slots[i] = q->slots[(q->head + i) % q->capacity];
+        }
+        free(q->slots);
+        q->slots = slots;
+        q->head = 0;
+        q->capacity = capacity;
+    }
+    q->slots[(q->head + q->count) % q->capacity] = slot;
+    q->count++;
+}
+
+int runq_pop(run_queue_t *q) {
+    if (q->count == 0) {
+        return -1;
+    }
+    int slot = q->slots[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    return slot;
+}
+
+void runq_destroy(run_queue_t *q) {
+    free(q->slots);
+    memset(q, 0, sizeof(*q));
+}
+
+void fairness_add(fairness_t *f, double x) {
+    f->sum += x;
+    f->sum_sq += x * x;
+    f->count++;
+}
+
+void fairness_merge(fairness_t *dst, const fairness_t *src) {
+    dst->sum += src->sum;
+    dst->sum_sq += src->sum_sq;
+    dst->count += src->count;
+}
+
+// 1.0 when every connection got the same throughput, 1/n when one got all
+double fairness_jain(const fairness_t *f) {
+    if (f->count == 0 || f->sum_sq <= 0.0) {
+        return 0.0;
+    }
+    return f->sum * f->sum / (f->count * f->sum_sq);
+}
+
+void sched_print_summary(void) {
+    latency_histogram_t wait, service;
+    fairness_t fairness = {0};
+
+    histogram_reset(&wait);
+    histogram_reset(&service);
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        server_thread_meta_t *meta = &g_ctx.server_threads[i];
+        histogram_merge(&wait, &meta->sched_wait);
+        histogram_merge(&service, &meta->sched_service);
+        fairness_merge(&fairness, &meta->fairness);
+    }
+
+    printf("  %-22s %s", "Scheduler:", sched_name(g_ctx.sched));
+    if (g_ctx.sched != SERVER_SCHED_FIFO) {
+        printf(", %d bytes per visit", g_ctx.conn_budget);
+    }
+    printf(", Jain fairness %.3f over %lu connections\n", fairness_jain(&fairness), fairness.count);
+    printf("Read scheduling (ready to served, time per visit):\n");
+    histogram_print("wait", &wait);
+    histogram_print("service", &service);
+}
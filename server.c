@@ -4,35 +4,468 @@
 volatile int global_connections_accepted = 0;
 volatile int global_connections_closed = 0;
 
+// epoll data for the two non-connection descriptors; connections use their
+// slab slot index
+#define EPOLL_TAG_LISTEN UINT64_MAX
+#define EPOLL_TAG_SHUTDOWN (UINT64_MAX - 1)
+
+// Outcome of serving a connection
+enum {
+    SERVE_IDLE = 0,   // Everything available was read and answered
+    SERVE_MORE,       // Budget spent; more data may be waiting
+    SERVE_BLOCKED,    // A response is parked until the socket drains
+    SERVE_CREDIT,     // DRR: the next frame needs more credit than is left
+    SERVE_CLOSED,     // Peer closed the connection (released)
+    SERVE_ERROR       // Malformed input (released)
+};
+
+static void release_connection(server_thread_meta_t *meta, int slot) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    accepted_socket_stats_t *stats = slab_cold(&meta->conns, slot);
+    uint64_t lifetime_ns = now_monotonic_ns() - stats->accepted_ns;
+    
+    // Connections that never sent anything (client pool spares) asked for
+    // no service and have no share in the fairness index
+    if (stats->bytes_received > 0 && lifetime_ns > 0) {
+        fairness_add(&meta->fairness, stats->bytes_received * 1e9 / lifetime_ns);
+    }
+    epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, sock->socket_fd, NULL);
+    tls_conn_free(&sock->tls);
+    close(sock->socket_fd);
+    free(sock->rx_buffer);
+    sock->rx_buffer = NULL;
+    sock->rx_length = 0;
+    sock->rx_offset = 0;
+    sock->rx_capacity = 0;
+    free(sock->tx);
+    sock->tx = NULL;
+    if (sock->tx_blocked) {
+        meta->parked_connections--;
+        sock->tx_blocked = 0;
+    }
+    sock->queued = 0;
+    sock->socket_fd = -1;
+    slab_free(&meta->conns, slot);
+    meta->active_connections--;
+    __sync_fetch_and_add(&global_connections_closed, 1);
+}
+
+static void set_interest(server_thread_meta_t *meta, int slot, uint32_t events) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.u64 = (uint64_t)slot;
+    epoll_ctl(meta->epoll_fd, EPOLL_CTL_MOD, slab_hot(&meta->conns, slot)->socket_fd, &event);
+}
+
+// Write as much of a protocol response as the socket takes, *done bytes
+// in. The body is emitted as iovecs cycling over resp->body, so echoes go
+// straight out of the receive buffer and generated bodies out of one
+// shared fill buffer. Returns 0 once the response is complete, 1 if the
+// socket is full, -1 on error.
+static int write_response(server_thread_meta_t *meta, int slot, const protocol_response_t *resp, size_t *done) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    size_t total = resp->header_length + resp->body_length;
+    
+    while (*done < total) {
+        struct iovec iov[PROTOCOL_MAX_IOV];
+        int iovcnt = 0;
+        size_t pos = *done;
+        
+        if (pos < resp->header_length) {
+            iov[iovcnt].iov_base = (void *)(resp->header + pos);
+            iov[iovcnt].iov_len = resp->header_length - pos;
+            iovcnt++;
+            pos = resp->header_length;
+        }
+        while (iovcnt < PROTOCOL_MAX_IOV && pos < total) {
+            size_t offset = (pos - resp->header_length) % resp->body_chunk;
+            size_t len = resp->body_chunk - offset;
+            if (len > total - pos) {
+                len = total - pos;
+            }
+            iov[iovcnt].iov_base = (void *)(resp->body + offset);
+            iov[iovcnt].iov_len = len;
+            iovcnt++;
+            pos += len;
+        }
+        
+        ssize_t bytes_written = tls_conn_writev(&sock->tls, sock->socket_fd, iov, iovcnt);
+        if (bytes_written > 0) {
+            *done += bytes_written;
+            slab_cold(&meta->conns, slot)->bytes_sent += bytes_written;
+            meta->total_bytes_sent += bytes_written;
+        } else if (bytes_written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 1;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// The socket is full: park the rest of the response and wait for EPOLLOUT.
+// Reads stop until it is written, which pushes back on the client instead
+// of spinning on write() while other connections wait. A raw echo still
+// points into the thread's read buffer, so its bytes are copied.
+static void park_response(server_thread_meta_t *meta, int slot, const protocol_response_t *resp,
+                          size_t done, int copy_body) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    
+    if (!sock->tx) {
+        sock->tx = malloc(sizeof(*sock->tx));
+        if (!sock->tx) {
+            perror("malloc");
+            exit(1);
+        }
+    }
+    sock->tx->resp = *resp;
+    sock->tx->done = done;
+    if (copy_body) {
+        memcpy(sock->tx->data, resp->body, resp->body_length);
+        sock->tx->resp.body = sock->tx->data;
+    }
+    sock->tx_blocked = 1;
+    meta->parked_connections++;
+    set_interest(meta, slot, EPOLLOUT);
+}
+
+// Answer every complete frame in the receive buffer from rx_offset on.
+// Frames are parsed in place; once all are answered only a trailing
+// partial frame is moved to the front of the buffer for the next read.
+// If a response has to be parked, the frames behind it wait in the buffer.
+// With a budget (--sched drr) each frame is charged its request size and
+// answered only while the credit covers it; the rest wait for a later turn.
+static int answer_frames(server_thread_meta_t *meta, int slot, int64_t *budget) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    const protocol_ops_t *proto = g_ctx.protocol;
+    int client_fd = sock->socket_fd;
+    int rc = SERVE_IDLE;
+    
+    if (g_ctx.tuning.cork > 0) {
+        tuning_cork(client_fd, 1);
+    }
+    for (;;) {
+        protocol_frame_t frame;
+        long used = proto->parse(sock->rx_buffer + sock->rx_offset, sock->rx_length - sock->rx_offset, &frame);
+        if (used == 0) {
+            break;
+        }
+        if (used < 0) {
+            printf("SERVER THREAD %d: malformed %s frame on fd=%d, closing\n",
+                   meta->thread_index, proto->name, client_fd);
+            release_connection(meta, slot);
+            return SERVE_ERROR;
+        }
+        if (budget && used > *budget) {
+            rc = SERVE_CREDIT;
+            break;
+        }
+        
+        protocol_response_t resp;
+        size_t done = 0;
+        proto->respond(&frame, &resp);
+        sock->rx_offset += used;
+        meta->total_frames++;
+        if (budget) {
+            *budget -= used;
+        }
+        int wrc = write_response(meta, slot, &resp, &done);
+        if (wrc < 0) {
+            release_connection(meta, slot);
+            exit(1);
+        }
+        if (wrc > 0) {
+            park_response(meta, slot, &resp, done, 0);
+            rc = SERVE_BLOCKED;
+            break;
+        }
+    }
+    if (g_ctx.tuning.cork > 0) {
+        tuning_cork(client_fd, 0);
+    }
+    if (rc != SERVE_IDLE) {
+        return rc;
+    }
+    
+    // Keep the partial frame, growing the buffer if it cannot hold all of it
+    size_t remaining = sock->rx_length - sock->rx_offset;
+    if (sock->rx_offset > 0 && remaining > 0) {
+        memmove(sock->rx_buffer, sock->rx_buffer + sock->rx_offset, remaining);
+    }
+    sock->rx_length = remaining;
+    sock->rx_offset = 0;
+    if (remaining >= PROTOCOL_HEADER_SIZE) {
+        uint32_t be_length;
+        memcpy(&be_length, sock->rx_buffer, sizeof(be_length));
+        size_t needed = PROTOCOL_HEADER_SIZE + (size_t)ntohl(be_length);
+        if (needed > sock->rx_capacity) {
+            char *grown = realloc(sock->rx_buffer, needed);
+            if (!grown) {
+                perror("realloc");
+                exit(1);
+            }
+            sock->rx_buffer = grown;
+            sock->rx_capacity = needed;
+        }
+    }
+    return SERVE_IDLE;
+}
+
+// Size of the next read: everything that fits, cut to the remaining
+// budget (or deficit) under --sched rr/drr. Framed drr charges whole
+// frames as they are answered instead, so its reads are not cut.
+static size_t read_size(size_t space, int64_t budget) {
+    if (g_ctx.sched == SERVER_SCHED_DRR && g_ctx.protocol->framed) {
+        return space;
+    }
+    if (g_ctx.sched != SERVER_SCHED_FIFO && (int64_t)space > budget) {
+        return (size_t)budget;
+    }
+    return space;
+}
+
+// Framed protocols: one read into the connection's receive buffer, then
+// answer the frames it completed
+static int serve_framed(server_thread_meta_t *meta, int slot, int64_t *budget) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    int client_fd = sock->socket_fd;
+    int64_t *credit = g_ctx.sched == SERVER_SCHED_DRR ? budget : NULL;
+    
+    // DRR: frames left over when the last turn ran out of credit go first
+    if (credit && sock->rx_length > 0) {
+        int rc = answer_frames(meta, slot, credit);
+        if (rc != SERVE_IDLE) {
+            return rc;
+        }
+    }
+    
+    if (!sock->rx_buffer) {
+        sock->rx_buffer = malloc(BUFFER_SIZE);
+        if (!sock->rx_buffer) {
+            perror("malloc");
+            exit(1);
+        }
+        sock->rx_capacity = BUFFER_SIZE;
+        sock->rx_length = 0;
+    }
+    
+    ssize_t bytes_read = tls_conn_read(&sock->tls, client_fd, sock->rx_buffer + sock->rx_length,
+                                       read_size(sock->rx_capacity - sock->rx_length, *budget));
+    if (bytes_read == 0) {
+        release_connection(meta, slot);
+        return SERVE_CLOSED;
+    } else if (bytes_read == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return SERVE_IDLE;
+        }
+        release_connection(meta, slot);
+        exit(1);
+    }
+    
+    if (!credit) {
+        *budget -= bytes_read;
+    }
+    slab_cold(&meta->conns, slot)->bytes_received += bytes_read;
+    meta->total_bytes_received += bytes_read;
+    sock->rx_length += bytes_read;
+    if (g_ctx.tuning.quickack > 0) {
+        tuning_rearm_quickack(client_fd);
+    }
+    
+    int rc = answer_frames(meta, slot, credit);
+    return rc == SERVE_IDLE ? SERVE_MORE : rc;
+}
+
+// Raw protocol: echo back exactly what one read returned
+static int serve_raw(server_thread_meta_t *meta, int slot, char *buffer, int64_t *budget) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    int client_fd = sock->socket_fd;
+    
+    ssize_t bytes_read = tls_conn_read(&sock->tls, client_fd, buffer, read_size(BUFFER_SIZE, *budget));
+    if (bytes_read == 0) {
+        // Client closed connection
+        release_connection(meta, slot);
+        return SERVE_CLOSED;
+    } else if (bytes_read == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // A spurious wakeup under fifo; TLS reads also land here
+            // mid-record, and run-queue visits whenever the socket runs dry
+            if (!sock->tls.ssl && g_ctx.sched == SERVER_SCHED_FIFO) {
+                printf("SERVER THREAD %d: read() got EAGAIN/EWOULDBLOCK slot=%d, fd=%d\n", 
+                       meta->thread_index, slot, client_fd);
+            }
+            return SERVE_IDLE;
+        }
+        release_connection(meta, slot);
+        exit(1);
+    }
+    
+    // Successfully read data - echo it back
+    *budget -= bytes_read;
+    slab_cold(&meta->conns, slot)->bytes_received += bytes_read;
+    meta->total_bytes_received += bytes_read;
+    if (g_ctx.tuning.quickack > 0) {
+        tuning_rearm_quickack(client_fd);
+    }
+    
+    // Send back exactly the same amount, corked into as
+    // few segments as possible when TCP_CORK is enabled
+    protocol_response_t resp;
+    size_t done = 0;
+    resp.header_length = 0;
+    resp.body = buffer;
+    resp.body_length = (size_t)bytes_read;
+    resp.body_chunk = (size_t)bytes_read;
+    if (g_ctx.tuning.cork > 0) {
+        tuning_cork(client_fd, 1);
+    }
+    int wrc = write_response(meta, slot, &resp, &done);
+    if (wrc < 0) {
+        release_connection(meta, slot);
+        exit(1);
+    }
+    if (wrc > 0) {
+        park_response(meta, slot, &resp, done, 1);
+    }
+    if (g_ctx.tuning.cork > 0) {
+        tuning_cork(client_fd, 0);
+    }
+    return wrc > 0 ? SERVE_BLOCKED : SERVE_MORE;
+}
+
+// One visit: read and answer until the socket runs dry, a response blocks
+// or the budget is spent. Under fifo the budget is a single read, except
+// that records OpenSSL has already decrypted are drained too, since epoll
+// cannot report them; under rr/drr such a connection simply stays queued.
+// Records how long the connection waited since it became ready and how
+// long it held the thread.
+static int serve_visit(server_thread_meta_t *meta, int slot, char *buffer) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    uint64_t start_ns = now_monotonic_ns();
+    int64_t budget;
+    int rc;
+    
+    if (g_ctx.sched == SERVER_SCHED_DRR) {
+        sock->deficit += g_ctx.conn_budget;
+        // No credit this round: stay queued without reading
+        if (sock->deficit <= 0) {
+            return SERVE_MORE;
+        }
+        budget = sock->deficit;
+    } else if (g_ctx.sched == SERVER_SCHED_RR) {
+        budget = g_ctx.conn_budget;
+    } else {
+        budget = 1;
+    }
+    histogram_record(&meta->sched_wait, start_ns - sock->ready_ns);
+    
+    for (;;) {
+        rc = g_ctx.protocol->framed ? serve_framed(meta, slot, &budget) : serve_raw(meta, slot, buffer, &budget);
+        if (rc != SERVE_MORE) {
+            break;
+        }
+        if (budget <= 0 && !(g_ctx.sched == SERVER_SCHED_FIFO && tls_conn_pending(&sock->tls))) {
+            break;
+        }
+    }
+    
+    uint64_t end_ns = now_monotonic_ns();
+    histogram_record(&meta->sched_service, end_ns - start_ns);
+    if (rc == SERVE_CLOSED || rc == SERVE_ERROR) {
+        return rc;
+    }
+    // A connection that ran dry starts its next turn without credit; one
+    // that is still backlogged keeps what it did not spend
+    sock->deficit = rc == SERVE_IDLE ? 0 : budget;
+    if (rc == SERVE_CREDIT) {
+        rc = SERVE_MORE;
+    }
+    sock->ready_ns = end_ns;
+    return rc;
+}
+
+// EPOLLOUT on a connection with a parked response: write the rest, then
+// answer any frames buffered behind it and go back to reading
+static void flush_parked(server_thread_meta_t *meta, int slot) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    
+    int rc = write_response(meta, slot, &sock->tx->resp, &sock->tx->done);
+    if (rc < 0) {
+        release_connection(meta, slot);
+        exit(1);
+    }
+    if (rc > 0) {
+        return;
+    }
+    sock->tx_blocked = 0;
+    meta->parked_connections--;
+    if (g_ctx.protocol->framed && g_ctx.sched == SERVER_SCHED_DRR) {
+        // Frames buffered behind it are answered on the connection's
+        // next turn, against its credit
+        if (!sock->queued) {
+            sock->queued = 1;
+            sock->ready_ns = now_monotonic_ns();
+            runq_push(&meta->runq, slot);
+        }
+    } else if (g_ctx.protocol->framed && answer_frames(meta, slot, NULL) != SERVE_IDLE) {
+        return;
+    }
+    set_interest(meta, slot, EPOLLIN);
+}
+
+// Drive a nonblocking TLS handshake, switching epoll interest to whatever
+// direction OpenSSL is waiting on
+static void serve_handshake(server_thread_meta_t *meta, int slot) {
+    accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+    
+    int rc = tls_conn_handshake(&sock->tls);
+    if (rc == TLS_IO_CLOSED) {
+        release_connection(meta, slot);
+        return;
+    }
+    if (rc == TLS_IO_ERROR) {
+        printf("SERVER THREAD %d: TLS handshake failed on fd=%d, closing\n",
+               meta->thread_index, sock->socket_fd);
+        release_connection(meta, slot);
+        return;
+    }
+    set_interest(meta, slot, rc == TLS_IO_WANT_WRITE ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+}
+
 void *server_thread_func(void *arg) {
     server_thread_meta_t *meta = (server_thread_meta_t *)arg;
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    struct epoll_event event, events[MAX_EVENTS];
-    char buffer[BUFFER_SIZE];
+    struct sockaddr_storage server_addr, client_addr;
+    socklen_t server_len, client_len = sizeof(client_addr);
+    char endpoint[MAX_ADDRESS_LEN + 16];
+    struct epoll_event event;
     
-    // Initialize connections array
+    // Connection state grows with use; the event array only needs to cover
+    // the connections this thread may hold plus the listen and shutdown fds
     meta->active_connections = 0;
-    for (int i = 0; i < MAX_CONNECTIONS_PER_THREAD; i++) {
-        meta->accepted_sockets[i].is_active = 0;
-        meta->accepted_sockets[i].socket_fd = -1;
-        meta->accepted_sockets[i].bytes_received = 0;
-        meta->accepted_sockets[i].bytes_sent = 0;
+    slab_init(&meta->conns, g_ctx.max_connections);
+    int max_events = g_ctx.max_connections + 2 < MAX_EVENTS ? g_ctx.max_connections + 2 : MAX_EVENTS;
+    struct epoll_event *events = malloc(max_events * sizeof(*events));
+    char *buffer = malloc(BUFFER_SIZE);
+    if (!events || !buffer) {
+        perror("malloc");
+        exit(1);
     }
     
     // Create listen socket
-    meta->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    meta->listen_fd = transport_create_socket(SOCK_STREAM);
     if (meta->listen_fd == -1) {
         perror("socket");
         exit(1);
     }
     
-    // Set socket options
+    // Set socket options (address reuse only applies to IP transports)
     int opt = 1;
-    if (setsockopt(meta->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
+    if (transport_is_ip() &&
+        setsockopt(meta->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1) {
         perror("setsockopt");
         exit(1);
     }
+    tuning_apply(meta->listen_fd, TUNING_ROLE_LISTENER);
     
     // Set non-blocking
     if (set_socket_nonblocking(meta->listen_fd) == -1) {
@@ -40,12 +473,13 @@ void *server_thread_func(void *arg) {
     }
     
     // Bind socket
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = inet_addr(g_ctx.listen_ip);
-    server_addr.sin_port = htons(meta->port);
+    if (transport_build_address(meta->port, &server_addr, &server_len) == -1) {
+        fprintf(stderr, "Invalid listen address '%s'\n", g_ctx.listen_ip);
+        exit(1);
+    }
+    transport_unlink(meta->port); // Remove a stale Unix socket node from a previous run
     
-    if (bind(meta->listen_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+    if (bind(meta->listen_fd, (struct sockaddr *)&server_addr, server_len) == -1) {
         perror("bind");
         exit(1);
     }
@@ -55,6 +489,7 @@ void *server_thread_func(void *arg) {
         perror("listen");
         exit(1);
     }
+    tuning_report(meta->listen_fd, TUNING_ROLE_LISTENER);
     
     // Create epoll
     meta->epoll_fd = epoll_create1(0);
@@ -65,16 +500,31 @@ void *server_thread_func(void *arg) {
     
     // Add listen socket to epoll
     event.events = EPOLLIN;
-    event.data.fd = meta->listen_fd;
+    event.data.u64 = EPOLL_TAG_LISTEN;
     if (epoll_ctl(meta->epoll_fd, EPOLL_CTL_ADD, meta->listen_fd, &event) == -1) {
         perror("epoll_ctl add listen");
         exit(1);
     }
     
-    printf("Server thread %d listening on port %d\n", meta->thread_index, meta->port);
+    // Add the shutdown eventfd so a signal wakes this loop immediately
+    event.events = EPOLLIN;
+    event.data.u64 = EPOLL_TAG_SHUTDOWN;
+    if (epoll_ctl(meta->epoll_fd, EPOLL_CTL_ADD, g_ctx.shutdown_fd, &event) == -1) {
+        perror("epoll_ctl add shutdown eventfd");
+        exit(1);
+    }
+    uint64_t drain_deadline_ms = 0;
+    int drain_expired = 0;
+    
+    transport_format_endpoint(meta->port, endpoint, sizeof(endpoint));
+    printf("Server thread %d listening on %s (%s)\n", meta->thread_index, endpoint,
+           transport_name(g_ctx.transport));
     
     while (g_ctx.running) {
-        int nfds = epoll_wait(meta->epoll_fd, events, MAX_EVENTS, 100);
+        // While draining, a short quiet period means no echo is in flight;
+        // queued connections only need a non-blocking look for new events
+        int timeout = meta->runq.count > 0 ? 0 : drain_deadline_ms ? 10 : 100;
+        int nfds = loop_wait(&meta->loop, meta->epoll_fd, events, max_events, timeout);
         if (nfds == -1) {
             if (errno != EINTR) {
                 perror("epoll_wait");
@@ -82,17 +532,24 @@ void *server_thread_func(void *arg) {
             }
             continue;
         }
+        int client_events = 0;
+        uint64_t ready_ns = now_monotonic_ns();
+        
+        // Warm-up ended: scheduler and event loop statistics start over
+        if (meta->stats_epoch != g_ctx.server_stats_epoch) {
+            meta->stats_epoch = g_ctx.server_stats_epoch;
+            histogram_reset(&meta->sched_wait);
+            histogram_reset(&meta->sched_service);
+            memset(&meta->fairness, 0, sizeof(meta->fairness));
+            loop_stats_reset(&meta->loop);
+        }
         
         for (int i = 0; i < nfds; i++) {
-            if (events[i].data.fd == meta->listen_fd) {
-                // New connection - find available slot
-                int slot = -1;
-                for (int j = 0; j < MAX_CONNECTIONS_PER_THREAD; j++) {
-                    if (!meta->accepted_sockets[j].is_active) {
-                        slot = j;
-                        break;
-                    }
-                }
+            if (events[i].data.u64 == EPOLL_TAG_SHUTDOWN) {
+                continue;
+            } else if (events[i].data.u64 == EPOLL_TAG_LISTEN) {
+                // New connection - take a slot from the slab
+                int slot = slab_alloc(&meta->conns);
                 
                 if (slot == -1) {
                     // No slots available - accept and close immediately
@@ -114,6 +571,7 @@ void *server_thread_func(void *arg) {
                         perror("accept");
                         exit(1);
                     }
+                    slab_free(&meta->conns, slot);
                     continue;
                 }
                 
@@ -123,143 +581,184 @@ void *server_thread_func(void *arg) {
                     __sync_fetch_and_add(&global_connections_closed, 1);
                     exit(1);
                 }
+                tuning_apply(client_fd, TUNING_ROLE_ACCEPTED);
+                tuning_report(client_fd, TUNING_ROLE_ACCEPTED);
                 
-                // Store connection
-                meta->accepted_sockets[slot].socket_fd = client_fd;
-                meta->accepted_sockets[slot].bytes_received = 0;
-                meta->accepted_sockets[slot].bytes_sent = 0;
-                meta->accepted_sockets[slot].is_active = 1;
+                // Store connection (slab_alloc() hands out zeroed state)
+                accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+                sock->socket_fd = client_fd;
+                sock->is_active = 1;
+                slab_cold(&meta->conns, slot)->accepted_ns = ready_ns;
                 meta->active_connections++;
                 meta->total_accepts++;
                 __sync_fetch_and_add(&global_connections_accepted, 1);
                 
                 // Add to epoll
                 event.events = EPOLLIN;
-                event.data.fd = client_fd;
+                event.data.u64 = (uint64_t)slot;
                 if (epoll_ctl(meta->epoll_fd, EPOLL_CTL_ADD, client_fd, &event) == -1) {
                     perror("epoll_ctl add client");
                     close(client_fd);
-                    meta->accepted_sockets[slot].is_active = 0;
+                    slab_free(&meta->conns, slot);
                     meta->active_connections--;
                     __sync_fetch_and_add(&global_connections_closed, 1);
                     exit(1);
                 }
+                if (g_ctx.tls_enabled && tls_conn_start(&sock->tls, client_fd) == -1) {
+                    release_connection(meta, slot);
+                }
                 
             } else {
-                // Client socket event - find which connection
-                int client_fd = events[i].data.fd;
-                int slot = -1;
-                for (int j = 0; j < MAX_CONNECTIONS_PER_THREAD; j++) {
-                    if (meta->accepted_sockets[j].is_active && 
-                        meta->accepted_sockets[j].socket_fd == client_fd) {
-                        slot = j;
-                        break;
-                    }
+                // Client socket event - the slot comes straight from epoll
+                int slot = (int)events[i].data.u64;
+                accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+                client_events++;
+                if (!sock->is_active) {
+                    continue;
                 }
                 
-                if (slot == -1) {
-                    epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-                    close(client_fd);
+                if (sock->tls.state == TLS_STATE_HANDSHAKE) {
+                    serve_handshake(meta, slot);
+                    continue;
+                }
+                
+                // A parked response only waits for EPOLLOUT
+                if (sock->tx_blocked) {
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        release_connection(meta, slot);
+                    } else if (events[i].events & EPOLLOUT) {
+                        flush_parked(meta, slot);
+                    }
                     continue;
                 }
                 
                 if (events[i].events & EPOLLIN) {
-                    ssize_t bytes_read = read(client_fd, buffer, sizeof(buffer));
-                    
-                    if (bytes_read == 0) {
-                        // Client closed connection
-                        epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-                        close(client_fd);
-                        meta->accepted_sockets[slot].is_active = 0;
-                        meta->active_connections--;
-                        __sync_fetch_and_add(&global_connections_closed, 1);
-                        
-                    } else if (bytes_read == -1) {
-                        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                            printf("SERVER THREAD %d: read() got EAGAIN/EWOULDBLOCK slot=%d, fd=%d\n", 
-                                   meta->thread_index, slot, client_fd);
-                            continue; // Normal for non-blocking
-                        } else {
-                            epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-                            close(client_fd);
-                            meta->accepted_sockets[slot].is_active = 0;
-                            meta->active_connections--;
-                            __sync_fetch_and_add(&global_connections_closed, 1);
-                            exit(1);
-                        }
-                        
-                    } else {
-                        // Successfully read data - echo it back
-                        meta->accepted_sockets[slot].bytes_received += bytes_read;
-                        meta->total_bytes_received += bytes_read;
-                        
-                        // Send back exactly the same amount
-                        size_t total_written = 0;
-                        while (total_written < (size_t)bytes_read) {
-                            ssize_t bytes_written = write(client_fd, buffer + total_written, 
-                                                        bytes_read - total_written);
-                            
-                            if (bytes_written > 0) {
-                                total_written += bytes_written;
-                                meta->accepted_sockets[slot].bytes_sent += bytes_written;
-                                meta->total_bytes_sent += bytes_written;
-                                
-                            } else if (bytes_written == -1) {
-                                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                                    // Socket buffer full - keep trying
-                                    printf("SERVER THREAD %d: write() got EAGAIN/EWOULDBLOCK slot=%d, fd=%d, sent=%zu/%zd\n", 
-                                           meta->thread_index, slot, client_fd, total_written, bytes_read);
-                                    continue;
-                                } else {
-                                    epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-                                    close(client_fd);
-                                    meta->accepted_sockets[slot].is_active = 0;
-                                    meta->active_connections--;
-                                    __sync_fetch_and_add(&global_connections_closed, 1);
-                                    exit(1);
-                                }
-                            } else {
-                                epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-                                close(client_fd);
-                                meta->accepted_sockets[slot].is_active = 0;
-                                meta->active_connections--;
-                                __sync_fetch_and_add(&global_connections_closed, 1);
-                                exit(1);
-                            }
+                    if (g_ctx.sched == SERVER_SCHED_FIFO) {
+                        sock->ready_ns = ready_ns;
+                        if (serve_visit(meta, slot, buffer) == SERVE_CLOSED && drain_deadline_ms) {
+                            meta->drained_connections++;
                         }
+                    } else if (!sock->queued) {
+                        sock->queued = 1;
+                        sock->ready_ns = ready_ns;
+                        runq_push(&meta->runq, slot);
                     }
                 }
                 
                 // Check for other epoll events that indicate connection problems
-                if (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
-                    epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-                    close(client_fd);
-                    meta->accepted_sockets[slot].is_active = 0;
-                    meta->active_connections--;
-                    __sync_fetch_and_add(&global_connections_closed, 1);
+                // (Unix sockets report EPOLLHUP alongside the final EPOLLIN, so
+                // skip connections the read path has already closed, and leave
+                // queued ones to read their final bytes and EOF)
+                if (sock->is_active && !sock->queued &&
+                    (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP))) {
+                    release_connection(meta, slot);
                 }
             }
         }
+        
+        // One run-queue round over the connections queued before it
+        // started; those with data left rejoin at the back for the next one
+        for (int round = meta->runq.count; round > 0; round--) {
+            int slot = runq_pop(&meta->runq);
+            accepted_socket_meta_t *sock = slab_hot(&meta->conns, slot);
+            if (!sock->is_active || !sock->queued) {
+                continue; // Released (and maybe reused) while queued
+            }
+            sock->queued = 0;
+            int rc = serve_visit(meta, slot, buffer);
+            if (rc == SERVE_MORE) {
+                sock->queued = 1;
+                runq_push(&meta->runq, slot);
+            } else if (rc == SERVE_CLOSED && drain_deadline_ms) {
+                meta->drained_connections++;
+            }
+        }
+        
+        // Periodic TCP_INFO sampling, outside the per-event path
+        if (tcp_info_enabled()) {
+            uint64_t now_ms = now_monotonic_ms();
+            if (now_ms - meta->last_tcp_info_ms >= (uint64_t)g_ctx.tcp_info_interval_ms) {
+                tcp_info_agg_t agg;
+                tcp_info_agg_reset(&agg);
+                for (int j = 0; j < meta->conns.used; j++) {
+                    accepted_socket_meta_t *sock = slab_hot(&meta->conns, j);
+                    accepted_socket_stats_t *stats = slab_cold(&meta->conns, j);
+                    if (sock->is_active && tcp_info_should_sample(j) &&
+                        tcp_info_sample(sock->socket_fd, &stats->tcp_info) == 0) {
+                        tcp_info_agg_add(&agg, &stats->tcp_info);
+                    }
+                }
+                meta->tcp_info_agg = agg;
+                meta->last_tcp_info_ms = now_ms;
+            }
+        }
+        
+        // Graceful shutdown: stop accepting, then keep echoing until every
+        // connection is closed or quiet with nothing left to send, or the
+        // drain deadline expires
+        if (g_ctx.shutdown_requested) {
+            uint64_t now_ms = now_monotonic_ms();
+            if (drain_deadline_ms == 0) {
+                epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, g_ctx.shutdown_fd, NULL);
+                epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, meta->listen_fd, NULL);
+                close(meta->listen_fd);
+                meta->listen_fd = -1;
+                transport_unlink(meta->port);
+                drain_deadline_ms = now_ms + g_ctx.drain_timeout_ms;
+            } else if (meta->active_connections == 0 ||
+                       (client_events == 0 && meta->runq.count == 0 && meta->parked_connections == 0)) {
+                break;
+            } else if (now_ms >= drain_deadline_ms) {
+                drain_expired = 1;
+                break;
+            }
+        }
     }
     
-    // Cleanup
-    for (int i = 0; i < MAX_CONNECTIONS_PER_THREAD; i++) {
-        if (meta->accepted_sockets[i].is_active) {
-            close(meta->accepted_sockets[i].socket_fd);
-            __sync_fetch_and_add(&global_connections_closed, 1);
+    // Cleanup: connections still open were either idle (fully echoed) or
+    // still carrying traffic when the drain deadline expired; a parked
+    // response is an echo that never went out
+    for (int i = 0; i < meta->conns.used; i++) {
+        accepted_socket_meta_t *sock = slab_hot(&meta->conns, i);
+        if (sock->is_active) {
+            int parked = sock->tx_blocked;
+            release_connection(meta, i);
+            if (drain_expired || !g_ctx.running || parked) {
+                meta->forced_connections++;
+            } else {
+                meta->drained_connections++;
+            }
         }
     }
-    close(meta->listen_fd);
+    if (meta->listen_fd != -1) {
+        close(meta->listen_fd);
+        transport_unlink(meta->port);
+    }
     close(meta->epoll_fd);
+    meta->peak_slots = meta->conns.used;
+    meta->slab_bytes = slab_bytes(&meta->conns);
+    slab_destroy(&meta->conns);
+    runq_destroy(&meta->runq);
+    free(events);
+    free(buffer);
     
     return NULL;
 }
 
 int run_server(void) {
-    printf("Starting server with %d threads on ports %d-%d\n", 
-           g_ctx.num_threads, g_ctx.listen_port_start, 
+    printf("Starting %s%s server with %d threads on ports %d-%d\n", 
+           transport_name(g_ctx.transport), g_ctx.udp ? " UDP" : "", g_ctx.num_threads, g_ctx.listen_port_start, 
            g_ctx.listen_port_start + g_ctx.num_threads - 1);
     
+    if (!g_ctx.udp) {
+        slab_print_footprint();
+    }
+    
+    // Settle GSO/GRO support before any thread reads the flags
+    if (g_ctx.udp) {
+        udp_probe_offloads();
+    }
+    
     // Allocate server thread metadata
     g_ctx.server_threads = calloc(g_ctx.num_threads, sizeof(server_thread_meta_t));
     if (!g_ctx.server_threads) {
@@ -273,24 +772,91 @@ int run_server(void) {
         g_ctx.server_threads[i].port = g_ctx.listen_port_start + i;
         
         if (pthread_create(&g_ctx.server_threads[i].thread_id, NULL, 
-                          server_thread_func, &g_ctx.server_threads[i]) != 0) {
+                          g_ctx.udp ? udp_server_thread_func : server_thread_func,
+                          &g_ctx.server_threads[i]) != 0) {
             perror("pthread_create");
             return -1;
         }
     }
     
-    // Main loop - print global stats
-    while (g_ctx.running) {
-        sleep(2);
-        printf("MAIN: Global connections - accepted=%d, closed=%d, active=%d\n", 
-               global_connections_accepted, global_connections_closed, 
-               global_connections_accepted - global_connections_closed);
+    // Main loop - drive the measurement window every interval and print
+    // global stats every 2 seconds until shutdown is requested
+    struct pollfd shutdown_poll = { .fd = g_ctx.shutdown_fd, .events = POLLIN };
+    uint64_t last_print_ms = now_monotonic_ms();
+    loop_stats_t last_loop = {0};
+    while (g_ctx.running && !g_ctx.shutdown_requested) {
+        if (poll(&shutdown_poll, 1, MEASURE_INTERVAL_MS) != 0) {
+            continue;
+        }
+        
+        if (measure_active()) {
+            server_totals_t totals;
+            server_collect_totals(&totals);
+            int event = measure_tick(totals.bytes_received);
+            if (event == MEASURE_EVENT_STARTED) {
+                // Threads own their counters, so snapshot instead of resetting
+                g_ctx.server_baseline = totals;
+                g_ctx.tls_baseline = g_ctx.tls_stats;
+                g_ctx.server_stats_epoch++;
+                g_ctx.run_start_ns = now_monotonic_ns();
+                printf("MEASURE: warm-up complete, measurement started\n");
+            } else if (event == MEASURE_EVENT_ENDED) {
+                printf("MEASURE: measurement window complete\n");
+                request_shutdown();
+                break;
+            }
+        }
+        
+        uint64_t now_ms = now_monotonic_ms();
+        if (now_ms - last_print_ms < 2000) {
+            continue;
+        }
+        last_print_ms = now_ms;
+        if (measure_active()) {
+            char phase[64];
+            measure_format_phase(phase, sizeof(phase));
+            printf("MAIN: [%s] ", phase);
+        } else {
+            printf("MAIN: ");
+        }
+        if (g_ctx.udp) {
+            server_totals_t totals;
+            server_collect_totals(&totals);
+            printf("Datagrams echoed=%lu, %.1f per recvmmsg()\n", totals.frames,
+                   totals.recv_calls ? (double)totals.frames / totals.recv_calls : 0.0);
+        } else {
+            printf("Global connections - accepted=%d, closed=%d, active=%d\n", 
+                   global_connections_accepted, global_connections_closed, 
+                   global_connections_accepted - global_connections_closed);
+        }
+        if (tcp_info_enabled()) {
+            tcp_info_agg_t agg;
+            tcp_info_agg_reset(&agg);
+            for (int i = 0; i < g_ctx.num_threads; i++) {
+                tcp_info_agg_merge(&agg, &g_ctx.server_threads[i].tcp_info_agg);
+            }
+            tcp_info_print_agg("MAIN:", &agg);
+        }
+        loop_print_interval("MAIN:", &last_loop);
     }
     
-    // Wait for threads to finish
+    // Wait for threads to drain and finish
     for (int i = 0; i < g_ctx.num_threads; i++) {
         pthread_join(g_ctx.server_threads[i].thread_id, NULL);
     }
     
     return 0;
+}
+
+void server_collect_totals(server_totals_t *totals) {
+    memset(totals, 0, sizeof(*totals));
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        server_thread_meta_t *meta = &g_ctx.server_threads[i];
+        totals->accepts += meta->total_accepts;
+        totals->bytes_received += meta->total_bytes_received;
+        totals->bytes_sent += meta->total_bytes_sent;
+        totals->frames += meta->total_frames;
+        totals->recv_calls += meta->total_recv_calls;
+        totals->tx_drops += meta->total_tx_drops;
+    }
 } 
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "network_app.h"
+
+// Per-thread connection slab. Connection state lives in chunks of
+// SLAB_CHUNK_CONNECTIONS slots that are only allocated once a thread needs
+// them, so an idle thread costs nothing and a busy one grows to its actual
+// peak. Chunks never move, so slot pointers stay valid while the slab grows.
+// Hot fields touched on every event (accepted_socket_meta_t) are kept apart
+// from cold statistics (accepted_socket_stats_t), which keeps more live
+// connections per cache line on the event path. Released slots go on a LIFO
+// free list, so accept and lookup are O(1) and recently used (still cached)
+// slots are reused first.
+
+void slab_init(conn_slab_t *slab, int max_slots) {
+    memset(slab, 0, sizeof(*slab));
+    slab->max_slots = max_slots;
+}
+
+static void *slab_realloc(void *ptr, size_t size) {
+    void *grown = realloc(ptr, size);
+    if (!grown) {
+        perror("realloc");
+        exit(1);
+    }
+    return grown;
+}
+
+static int slab_grow(conn_slab_t *slab) {
+    if (slab->chunk_count == slab->chunk_slots) {
+        int slots = slab->chunk_slots ? slab->chunk_slots * 2 : 4;
+        slab->hot = slab_realloc(slab->hot, slots * sizeof(*slab->hot));
+        slab->cold = slab_realloc(slab->cold, slots * sizeof(*slab->cold));
+        slab->chunk_slots = slots;
+    }
+
+    accepted_socket_meta_t *hot = calloc(SLAB_CHUNK_CONNECTIONS, sizeof(*hot));
+    accepted_socket_stats_t *cold = calloc(SLAB_CHUNK_CONNECTIONS, sizeof(*cold));
+    if (!hot || !cold) {
+        free(hot);
+        free(cold);
+        return -1;
+    }
+    slab->hot[slab->chunk_count] = hot;
+    slab->cold[slab->chunk_count] = cold;
+    slab->chunk_count++;
+    slab->free_slots = slab_realloc(slab->free_slots,
+                                    (size_t)slab->chunk_count * SLAB_CHUNK_CONNECTIONS * sizeof(int));
+    return 0;
+}
+
+int slab_alloc(conn_slab_t *slab) {
+    int slot;
+
+    if (slab->free_count > 0) {
+        slot = slab->free_slots[--slab->free_count];
+    } else {
+        if (slab->used >= slab->max_slots) {
+            return -1;
+        }
+        if (slab->used == slab->chunk_count * SLAB_CHUNK_CONNECTIONS && slab_grow(slab) != 0) {
+            return -1;
+        }
+        slot = slab->used++;
+    }
+
+    accepted_socket_meta_t *sock = slab_hot(slab, slot);
+    memset(sock, 0, sizeof(*sock));
+    memset(slab_cold(slab, slot), 0, sizeof(accepted_socket_stats_t));
+    sock->socket_fd = -1;
+    return slot;
+}
+
+void slab_free(conn_slab_t *slab, int slot) {
+    slab_hot(slab, slot)->is_active = 0;
+    slab->free_slots[slab->free_count++] = slot;
+}
+
+accepted_socket_meta_t *slab_hot(conn_slab_t *slab, int slot) {
+    return &slab->hot[slot / SLAB_CHUNK_CONNECTIONS][slot % SLAB_CHUNK_CONNECTIONS];
+}
+
+accepted_socket_stats_t *slab_cold(conn_slab_t *slab, int slot) {
+    return &slab->cold[slot / SLAB_CHUNK_CONNECTIONS][slot % SLAB_CHUNK_CONNECTIONS];
+}
+
+size_t slab_bytes(const conn_slab_t *slab) {
+    return (size_t)slab->chunk_count * SLAB_CHUNK_CONNECTIONS *
+           (sizeof(accepted_socket_meta_t) + sizeof(accepted_socket_stats_t) + sizeof(int));
+}
+
+void slab_destroy(conn_slab_t *slab) {
+    for (int i = 0; i < slab->chunk_count; i++) {
+        free(slab->hot[i]);
+        free(slab->cold[i]);
+    }
+    free(slab->hot);
+    free(slab->cold);
+    free(slab->free_slots);
+    memset(slab, 0, sizeof(*slab));
+}
+
+void slab_print_footprint(void) {
+    size_t hot = sizeof(accepted_socket_meta_t);
+    size_t cold = sizeof(accepted_socket_stats_t);
+    size_t per_connection = hot + cold + sizeof(int);
+
+    printf("Connection state: %zu bytes per connection (%zu hot + %zu cold + free list), "
+           "allocated %d at a time (%.1f KB), up to %d per thread\n",
+           per_connection, hot, cold, SLAB_CHUNK_CONNECTIONS,
+           per_connection * SLAB_CHUNK_CONNECTIONS / 1024.0, g_ctx.max_connections);
+}
@@ -0,0 +1,96 @@
+#include "network_app.h"
+
+// Kernel TCP_INFO sampling. A configurable subset of connections (every Nth
+// index) is sampled with getsockopt(TCP_INFO) on a timer from the event
+// loops, outside the read/write path, and folded into min/avg/max aggregates
+// so throughput drops can be attributed to RTT, cwnd or retransmits.
+
+int tcp_info_enabled(void) {
+    return g_ctx.tcp_info_every > 0 && transport_is_ip();
+}
+
+int tcp_info_should_sample(int index) {
+    return index % g_ctx.tcp_info_every == 0;
+}
+
+int tcp_info_sample(int fd, tcp_info_sample_t *out) {
+    struct tcp_info info;
+    socklen_t len = sizeof(info);
+
+    memset(&info, 0, sizeof(info));
+    if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) == -1) {
+        out->valid = 0;
+        return -1;
+    }
+
+    out->rtt_us = info.tcpi_rtt;
+    out->rttvar_us = info.tcpi_rttvar;
+    out->snd_cwnd = info.tcpi_snd_cwnd;
+    out->total_retrans = info.tcpi_total_retrans;
+    out->unacked_bytes = info.tcpi_unacked * info.tcpi_snd_mss;
+    out->valid = 1;
+    return 0;
+}
+
+static void tcp_info_stat_add(tcp_info_stat_t *stat, uint64_t value) {
+    if (stat->count == 0 || value < stat->min) {
+        stat->min = value;
+    }
+    if (stat->count == 0 || value > stat->max) {
+        stat->max = value;
+    }
+    stat->sum += value;
+    stat->count++;
+}
+
+static void tcp_info_stat_merge(tcp_info_stat_t *dst, const tcp_info_stat_t *src) {
+    if (src->count == 0) {
+        return;
+    }
+    if (dst->count == 0 || src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (dst->count == 0 || src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->sum += src->sum;
+    dst->count += src->count;
+}
+
+void tcp_info_agg_reset(tcp_info_agg_t *agg) {
+    memset(agg, 0, sizeof(*agg));
+}
+
+void tcp_info_agg_add(tcp_info_agg_t *agg, const tcp_info_sample_t *sample) {
+    if (!sample->valid) {
+        return;
+    }
+    tcp_info_stat_add(&agg->rtt_us, sample->rtt_us);
+    tcp_info_stat_add(&agg->snd_cwnd, sample->snd_cwnd);
+    tcp_info_stat_add(&agg->total_retrans, sample->total_retrans);
+    tcp_info_stat_add(&agg->unacked_bytes, sample->unacked_bytes);
+}
+
+void tcp_info_agg_merge(tcp_info_agg_t *dst, const tcp_info_agg_t *src) {
+    tcp_info_stat_merge(&dst->rtt_us, &src->rtt_us);
+    tcp_info_stat_merge(&dst->snd_cwnd, &src->snd_cwnd);
+    tcp_info_stat_merge(&dst->total_retrans, &src->total_retrans);
+    tcp_info_stat_merge(&dst->unacked_bytes, &src->unacked_bytes);
+}
+
+static void tcp_info_print_stat(const char *name, const tcp_info_stat_t *stat) {
+    if (stat->count == 0) {
+        printf(" %s -/-/-", name);
+        return;
+    }
+    printf(" %s %lu/%lu/%lu", name, stat->min, stat->sum / stat->count, stat->max);
+}
+
+void tcp_info_print_agg(const char *label, const tcp_info_agg_t *agg) {
+    printf("%s TCP_INFO (min/avg/max, %lu conns):", label, agg->rtt_us.count);
+    tcp_info_print_stat("RTT us", &agg->rtt_us);
+    tcp_info_print_stat("| cwnd", &agg->snd_cwnd);
+    tcp_info_print_stat("| retrans", &agg->total_retrans);
+    tcp_info_print_stat("| unacked B", &agg->unacked_bytes);
+    printf("\n");
+}
@@ -0,0 +1,339 @@
+#include "network_app.h"
+
+// Optional TLS mode. Handshakes run nonblocking inside the existing epoll
+// loops; once a session is established OpenSSL hands the keys to kernel TLS
+// (TCP_ULP "tls", enabled through SSL_OP_ENABLE_KTLS) and the data path goes
+// back to plain read()/write() on the socket. Directions the kernel could
+// not take over fall back to SSL_read()/SSL_write().
+
+#ifdef HAVE_TLS
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+
+static SSL_CTX *tls_ctx = NULL;
+
+static void tls_print_errors(const char *what) {
+    unsigned long err = ERR_get_error();
+    char buf[256];
+
+    ERR_error_string_n(err, buf, sizeof(buf));
+    fprintf(stderr, "TLS: %s failed: %s\n", what, err ? buf : "unknown error");
+    ERR_clear_error();
+}
+
+// Self-signed P-256 certificate generated at startup; the client does not
+// verify it, the point is the cost of the handshake and the record layer
+static int tls_load_self_signed(SSL_CTX *ctx) {
+    EVP_PKEY *pkey = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    int ok = 0;
+
+    if (!pkey || !cert) {
+        tls_print_errors("key generation");
+        goto out;
+    }
+
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 7 * 24 * 3600);
+    X509_set_pubkey(cert, pkey);
+
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"network_app", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    if (!X509_sign(cert, pkey, EVP_sha256()) ||
+        SSL_CTX_use_certificate(ctx, cert) != 1 ||
+        SSL_CTX_use_PrivateKey(ctx, pkey) != 1) {
+        tls_print_errors("self-signed certificate");
+        goto out;
+    }
+    ok = 1;
+
+out:
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    return ok ? 0 : -1;
+}
+
+int tls_init(void) {
+    if (!g_ctx.tls_enabled) {
+        return 0;
+    }
+
+    tls_ctx = SSL_CTX_new(g_ctx.is_server ? TLS_server_method() : TLS_client_method());
+    if (!tls_ctx) {
+        tls_print_errors("SSL_CTX_new");
+        return -1;
+    }
+
+    int version = g_ctx.tls_version == 13 ? TLS1_3_VERSION : TLS1_2_VERSION;
+    SSL_CTX_set_min_proto_version(tls_ctx, version);
+    SSL_CTX_set_max_proto_version(tls_ctx, version);
+    // No session tickets: a post-handshake ticket record would reach a
+    // kTLS receive socket as a control message and fail plain read()
+    SSL_CTX_set_options(tls_ctx, SSL_OP_NO_TICKET);
+    // Peers close without close_notify; report that as a plain EOF
+    SSL_CTX_set_options(tls_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+    SSL_CTX_set_num_tickets(tls_ctx, 0);
+    if (g_ctx.tls_ktls) {
+        SSL_CTX_set_options(tls_ctx, SSL_OP_ENABLE_KTLS);
+    }
+    // Retried writes may resume from a different (cycled) buffer address
+    SSL_CTX_set_mode(tls_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    if (g_ctx.is_server) {
+        return tls_load_self_signed(tls_ctx);
+    }
+    SSL_CTX_set_verify(tls_ctx, SSL_VERIFY_NONE, NULL);
+    return 0;
+}
+
+void tls_cleanup(void) {
+    if (tls_ctx) {
+        SSL_CTX_free(tls_ctx);
+        tls_ctx = NULL;
+    }
+}
+
+int tls_conn_start(tls_conn_t *t, int fd) {
+    SSL *ssl = SSL_new(tls_ctx);
+    if (!ssl || SSL_set_fd(ssl, fd) != 1) {
+        tls_print_errors("SSL_new");
+        SSL_free(ssl);
+        return -1;
+    }
+    if (g_ctx.is_server) {
+        SSL_set_accept_state(ssl);
+    } else {
+        SSL_set_connect_state(ssl);
+    }
+
+    // Handshake flights and the records that follow are small back-to-back
+    // writes that Nagle would hold for a delayed ACK, so TLS sockets keep
+    // TCP_NODELAY on unless the profile sets it
+    if (g_ctx.tuning.nodelay < 0 && transport_is_ip()) {
+        tuning_nodelay(fd, 1);
+    }
+
+    t->ssl = ssl;
+    t->state = TLS_STATE_HANDSHAKE;
+    t->ktls_tx = 0;
+    t->ktls_rx = 0;
+    t->handshake_start_ns = now_monotonic_ns();
+    return 0;
+}
+
+// The handshake failed because the peer closed or reset the connection
+static int tls_handshake_eof(int err) {
+    if (err == SSL_ERROR_ZERO_RETURN) {
+        return 1;
+    }
+    if (err == SSL_ERROR_SYSCALL) {
+        return errno == 0 || errno == ECONNRESET || errno == EPIPE;
+    }
+#ifdef SSL_R_UNEXPECTED_EOF_WHILE_READING
+    return ERR_GET_REASON(ERR_peek_last_error()) == SSL_R_UNEXPECTED_EOF_WHILE_READING;
+#else
+    return 0;
+#endif
+}
+
+int tls_conn_handshake(tls_conn_t *t) {
+    SSL *ssl = t->ssl;
+    errno = 0;
+    int ret = SSL_do_handshake(ssl);
+
+    if (ret != 1) {
+        int err = SSL_get_error(ssl, ret);
+        switch (err) {
+            case SSL_ERROR_WANT_READ:
+                return TLS_IO_WANT_READ;
+            case SSL_ERROR_WANT_WRITE:
+                return TLS_IO_WANT_WRITE;
+            default: {
+                int eof = tls_handshake_eof(err);
+                ERR_clear_error();
+                // Nothing received yet: the peer never attempted a handshake
+                if (BIO_number_read(SSL_get_rbio(ssl)) == 0) {
+                    return TLS_IO_CLOSED;
+                }
+                // A peer hanging up while we shut down is part of the drain
+                if (eof && g_ctx.shutdown_requested) {
+                    return TLS_IO_CLOSED;
+                }
+                __sync_fetch_and_add(&g_ctx.tls_stats.handshake_failures, 1);
+                return TLS_IO_ERROR;
+            }
+        }
+    }
+
+    t->state = TLS_STATE_ESTABLISHED;
+    t->ktls_tx = BIO_get_ktls_send(SSL_get_wbio(ssl)) ? 1 : 0;
+    t->ktls_rx = BIO_get_ktls_recv(SSL_get_rbio(ssl)) ? 1 : 0;
+
+    __sync_fetch_and_add(&g_ctx.tls_stats.handshakes, 1);
+    if (t->ktls_tx) {
+        __sync_fetch_and_add(&g_ctx.tls_stats.ktls_tx, 1);
+    }
+    if (t->ktls_rx) {
+        __sync_fetch_and_add(&g_ctx.tls_stats.ktls_rx, 1);
+    }
+    return TLS_IO_DONE;
+}
+
+// Map an SSL_read/SSL_write result onto read()/write() conventions
+static ssize_t tls_io_result(SSL *ssl, int ret) {
+    if (ret > 0) {
+        return ret;
+    }
+    switch (SSL_get_error(ssl, ret)) {
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            errno = EAGAIN;
+            return -1;
+        case SSL_ERROR_ZERO_RETURN:
+            return 0;
+        case SSL_ERROR_SYSCALL:
+            ERR_clear_error();
+            if (errno == 0) {
+                return 0; // EOF without close_notify
+            }
+            return -1;
+        default:
+            ERR_clear_error();
+            errno = EPROTO;
+            return -1;
+    }
+}
+
+ssize_t tls_conn_read(tls_conn_t *t, int fd, void *buf, size_t len) {
+    if (!t->ssl || t->ktls_rx) {
+        return read(fd, buf, len);
+    }
+    errno = 0;
+    return tls_io_result(t->ssl, SSL_read(t->ssl, buf, (int)len));
+}
+
+ssize_t tls_conn_write(tls_conn_t *t, int fd, const void *buf, size_t len) {
+    if (!t->ssl || t->ktls_tx) {
+        return write(fd, buf, len);
+    }
+    errno = 0;
+    return tls_io_result(t->ssl, SSL_write(t->ssl, buf, (int)len));
+}
+
+ssize_t tls_conn_writev(tls_conn_t *t, int fd, const struct iovec *iov, int iovcnt) {
+    if (!t->ssl || t->ktls_tx) {
+        return writev(fd, iov, iovcnt);
+    }
+
+    // SSL has no gather write: write the vectors in order, stopping at the
+    // first short write so the caller can resume from the byte count
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        ssize_t n = tls_conn_write(t, fd, iov[i].iov_base, iov[i].iov_len);
+        if (n <= 0) {
+            return total > 0 ? total : n;
+        }
+        total += n;
+        if ((size_t)n < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+int tls_conn_pending(const tls_conn_t *t) {
+    if (!t->ssl || t->ktls_rx) {
+        return 0;
+    }
+    return SSL_pending(t->ssl);
+}
+
+void tls_conn_free(tls_conn_t *t) {
+    // No SSL_shutdown(): a close_notify alert would arrive on a kTLS receive
+    // socket as a control record, so connections just close the socket
+    if (t->ssl) {
+        SSL_free(t->ssl);
+    }
+    t->ssl = NULL;
+    t->state = TLS_STATE_NONE;
+    t->ktls_tx = 0;
+    t->ktls_rx = 0;
+}
+
+#else // !HAVE_TLS
+
+int tls_init(void) {
+    if (g_ctx.tls_enabled) {
+        fprintf(stderr, "Error: TLS requested but network_app was built with TLS=0\n");
+        return -1;
+    }
+    return 0;
+}
+
+void tls_cleanup(void) {
+}
+
+int tls_conn_start(tls_conn_t *t, int fd) {
+    (void)t;
+    (void)fd;
+    return -1;
+}
+
+int tls_conn_handshake(tls_conn_t *t) {
+    (void)t;
+    return TLS_IO_ERROR;
+}
+
+ssize_t tls_conn_read(tls_conn_t *t, int fd, void *buf, size_t len) {
+    (void)t;
+    return read(fd, buf, len);
+}
+
+ssize_t tls_conn_write(tls_conn_t *t, int fd, const void *buf, size_t len) {
+    (void)t;
+    return write(fd, buf, len);
+}
+
+ssize_t tls_conn_writev(tls_conn_t *t, int fd, const struct iovec *iov, int iovcnt) {
+    (void)t;
+    return writev(fd, iov, iovcnt);
+}
+
+int tls_conn_pending(const tls_conn_t *t) {
+    (void)t;
+    return 0;
+}
+
+void tls_conn_free(tls_conn_t *t) {
+    t->ssl = NULL;
+    t->state = TLS_STATE_NONE;
+}
+
+#endif // HAVE_TLS
+
+void tls_print_summary(void) {
+    if (!g_ctx.tls_enabled) {
+        return;
+    }
+    double seconds = ((g_ctx.run_end_ns ? g_ctx.run_end_ns : now_monotonic_ns()) - g_ctx.run_start_ns) / 1e9;
+    tls_stats_t stats = g_ctx.tls_stats;
+    tls_stats_t *st = &stats;
+
+    // Exclude warm-up (the server snapshots instead of resetting)
+    st->handshakes -= g_ctx.tls_baseline.handshakes;
+    st->handshake_failures -= g_ctx.tls_baseline.handshake_failures;
+    st->ktls_tx -= g_ctx.tls_baseline.ktls_tx;
+    st->ktls_rx -= g_ctx.tls_baseline.ktls_rx;
+
+    printf("  %-22s TLS 1.%d, %lu handshakes (%.1f/s), %lu failed\n", "TLS:", g_ctx.tls_version - 10,
+           st->handshakes, seconds > 0 ? st->handshakes / seconds : 0.0, st->handshake_failures);
+    printf("  %-22s kTLS %s: %lu TX, %lu RX offloaded of %lu sessions\n", "",
+           g_ctx.tls_ktls ? "on" : "off", st->ktls_tx, st->ktls_rx, st->handshakes);
+}
@@ -0,0 +1,416 @@
+#include "network_app.h"
+
+// Workload traces. A trace is the sequence of sends a client made: which
+// connection, when (relative to the start), and how many bytes. --record
+// writes one record per successful write() of a normal run; --replay maps a
+// trace read-only and releases each record's bytes to its connection once
+// the record is due, so the send path reproduces the original burst pattern
+// (optionally sped up or slowed down by --replay-speed, or with every record
+// released at once for --replay-speed 0). Traces from elsewhere can be
+// converted from CSV with --trace-convert.
+//
+// The file is a trace_header_t followed by 16-byte trace_record_t entries
+// in time order, in host byte order; traces are meant to be replayed on the
+// kind of machine that recorded them.
+
+static struct {
+    int fd;
+    uint64_t start_ns;
+    uint32_t connections;
+    uint64_t records;
+    size_t buffered;
+    trace_record_t *buffer;
+} recorder = { .fd = -1 };
+
+static struct {
+    void *map;
+    size_t map_len;
+    const trace_record_t *records;
+    uint64_t count;
+    uint64_t next;
+    uint32_t connections;
+    uint64_t start_ns;
+    uint64_t bytes;
+    uint64_t lag_sum_ns;
+    uint64_t lag_max_ns;
+} replay;
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void trace_header_init(trace_header_t *header, uint32_t connections) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+    header->version = TRACE_VERSION;
+    header->connections = connections;
+}
+
+// Map a trace file and validate its header; returns the record count or -1
+static long trace_map(const char *path, void **map, size_t *map_len, uint32_t *connections) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "Error: Cannot open trace '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        fprintf(stderr, "Error: Cannot stat trace '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    const trace_header_t *header;
+    size_t len = (size_t)st.st_size;
+    if (len < sizeof(*header) || (len - sizeof(*header)) % sizeof(trace_record_t) != 0) {
+        fprintf(stderr, "Error: '%s' is not a trace file (bad size)\n", path);
+        close(fd);
+        return -1;
+    }
+    void *addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map trace '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    header = addr;
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 || header->version != TRACE_VERSION) {
+        fprintf(stderr, "Error: '%s' is not a version %d trace file\n", path, TRACE_VERSION);
+        munmap(addr, len);
+        return -1;
+    }
+    madvise(addr, len, MADV_SEQUENTIAL);
+
+    *map = addr;
+    *map_len = len;
+    *connections = header->connections;
+    return (long)((len - sizeof(*header)) / sizeof(trace_record_t));
+}
+
+int trace_record_open(const char *path) {
+    recorder.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (recorder.fd == -1) {
+        fprintf(stderr, "Error: Cannot create trace '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    recorder.buffer = malloc(TRACE_RECORD_BUFFER * sizeof(*recorder.buffer));
+    if (!recorder.buffer) {
+        perror("malloc");
+        exit(1);
+    }
+
+    // The header is rewritten with the connection count on close
+    trace_header_t header;
+    trace_header_init(&header, 0);
+    if (write_all(recorder.fd, &header, sizeof(header)) == -1) {
+        perror("write trace header");
+        return -1;
+    }
+    recorder.start_ns = now_monotonic_ns();
+    return 0;
+}
+
+static void trace_record_flush(void) {
+    if (recorder.buffered > 0 &&
+        write_all(recorder.fd, recorder.buffer, recorder.buffered * sizeof(*recorder.buffer)) == -1) {
+        perror("write trace");
+        exit(1);
+    }
+    recorder.buffered = 0;
+}
+
+void trace_record_add(int connection, uint32_t size) {
+    if (recorder.fd == -1) {
+        return;
+    }
+    trace_record_t *rec = &recorder.buffer[recorder.buffered++];
+    rec->time_ns = now_monotonic_ns() - recorder.start_ns;
+    rec->connection = (uint32_t)connection;
+    rec->size = size;
+    if ((uint32_t)connection >= recorder.connections) {
+        recorder.connections = (uint32_t)connection + 1;
+    }
+    recorder.records++;
+    if (recorder.buffered == TRACE_RECORD_BUFFER) {
+        trace_record_flush();
+    }
+}
+
+void trace_record_close(void) {
+    if (recorder.fd == -1) {
+        return;
+    }
+    trace_record_flush();
+    trace_header_t header;
+    trace_header_init(&header, recorder.connections);
+    if (pwrite(recorder.fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        perror("write trace header");
+    }
+    close(recorder.fd);
+    recorder.fd = -1;
+    free(recorder.buffer);
+    recorder.buffer = NULL;
+}
+
+int trace_replay_open(const char *path) {
+    long count = trace_map(path, &replay.map, &replay.map_len, &replay.connections);
+    if (count < 0) {
+        return -1;
+    }
+    replay.records = (const trace_record_t *)((const char *)replay.map + sizeof(trace_header_t));
+    replay.count = (uint64_t)count;
+    return 0;
+}
+
+void trace_replay_start(void) {
+    replay.start_ns = now_monotonic_ns();
+    replay.next = 0;
+}
+
+// Trace time of a record on the replay clock. A very slow replay can push
+// it past what uint64_t holds, so clamp before converting; such a record is
+// simply never due.
+static uint64_t trace_due_ns(const trace_record_t *rec) {
+    if (g_ctx.replay_speed <= 0) {
+        return 0;
+    }
+    double due_ns = rec->time_ns / g_ctx.replay_speed;
+    if (due_ns >= 18446744073709551616.0) {
+        return UINT64_MAX;
+    }
+    return (uint64_t)due_ns;
+}
+
+// Release every record that is due to its connection's send credit;
+// returns the number released
+int trace_replay_release(void) {
+    uint64_t elapsed_ns = now_monotonic_ns() - replay.start_ns;
+    int released = 0;
+
+    while (replay.next < replay.count) {
+        const trace_record_t *rec = &replay.records[replay.next];
+        uint64_t due_ns = trace_due_ns(rec);
+        if (due_ns > elapsed_ns) {
+            break;
+        }
+        uint64_t lag_ns = elapsed_ns - due_ns;
+        if (g_ctx.replay_speed > 0) {
+            replay.lag_sum_ns += lag_ns;
+            if (lag_ns > replay.lag_max_ns) {
+                replay.lag_max_ns = lag_ns;
+            }
+        }
+        g_ctx.client_connections[rec->connection % (uint32_t)g_ctx.num_threads].replay_credit += rec->size;
+        replay.bytes += rec->size;
+        replay.next++;
+        released++;
+    }
+    return released;
+}
+
+// epoll_wait() timeout that wakes up for the next record: 0 once it is
+// less than a millisecond away, since epoll cannot sleep any shorter
+int trace_replay_timeout_ms(int max_ms) {
+    if (replay.next >= replay.count) {
+        return max_ms;
+    }
+    uint64_t due_ns = trace_due_ns(&replay.records[replay.next]);
+    uint64_t elapsed_ns = now_monotonic_ns() - replay.start_ns;
+    if (due_ns <= elapsed_ns + 1000000) {
+        return 0;
+    }
+    uint64_t wait_ms = (due_ns - elapsed_ns) / 1000000;
+    return wait_ms < (uint64_t)max_ms ? (int)wait_ms : max_ms;
+}
+
+int trace_replay_done(void) {
+    return replay.next >= replay.count;
+}
+
+void trace_replay_close(void) {
+    if (replay.map) {
+        munmap(replay.map, replay.map_len);
+        replay.map = NULL;
+    }
+}
+
+uint32_t trace_replay_connections(void) {
+    return replay.connections;
+}
+
+void trace_print_summary(void) {
+    if (g_ctx.record_path) {
+        printf("  %-22s %lu sends from %u connection(s) written to %s\n", "Recorded:",
+               recorder.records, recorder.connections, g_ctx.record_path);
+    }
+    if (!g_ctx.replay_path) {
+        return;
+    }
+    printf("  %-22s %lu of %lu records, %lu bytes released", "Replayed:", replay.next, replay.count, replay.bytes);
+    if (g_ctx.replay_speed > 0) {
+        printf(" at %gx, lag avg %.1f us, max %.1f us\n", g_ctx.replay_speed,
+               replay.next > 0 ? replay.lag_sum_ns / 1e3 / replay.next : 0.0, replay.lag_max_ns / 1e3);
+    } else {
+        printf(" as fast as possible\n");
+    }
+}
+
+// CSV lines are "time_us,connection,size"; a non-numeric first line is
+// taken as a header and skipped
+static int trace_csv_to_binary(FILE *in, int out_fd) {
+    char line[256];
+    trace_record_t *buffer = malloc(TRACE_RECORD_BUFFER * sizeof(*buffer));
+    size_t buffered = 0;
+    uint64_t records = 0, last_ns = 0;
+    uint32_t connections = 0;
+    long line_no = 0;
+
+    if (!buffer) {
+        perror("malloc");
+        return -1;
+    }
+    trace_header_t header;
+    trace_header_init(&header, 0);
+    if (write_all(out_fd, &header, sizeof(header)) == -1) {
+        perror("write trace header");
+        free(buffer);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), in)) {
+        double time_us;
+        unsigned long connection, size;
+        line_no++;
+        if (line[0] == '\n' || line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%lf,%lu,%lu", &time_us, &connection, &size) != 3) {
+            if (line_no == 1) {
+                continue;
+            }
+            fprintf(stderr, "Error: Trace CSV line %ld: expected time_us,connection,size\n", line_no);
+            free(buffer);
+            return -1;
+        }
+        // Range-check the timestamp before converting it: casting a negative,
+        // NaN or too-large double to uint64_t is undefined
+        double time_ns_f = time_us * 1000.0 + 0.5;
+        if (!isfinite(time_ns_f) || time_us < 0 || time_ns_f >= 18446744073709551616.0 ||
+            connection > UINT32_MAX || size > UINT32_MAX) {
+            fprintf(stderr, "Error: Trace CSV line %ld: time, connection or size out of range\n", line_no);
+            free(buffer);
+            return -1;
+        }
+        uint64_t time_ns = (uint64_t)time_ns_f;
+        if (time_ns < last_ns) {
+            fprintf(stderr, "Error: Trace CSV line %ld: time goes backwards (records must be in time order)\n",
+                    line_no);
+            free(buffer);
+            return -1;
+        }
+
+        trace_record_t *rec = &buffer[buffered++];
+        rec->time_ns = time_ns;
+        rec->connection = (uint32_t)connection;
+        rec->size = (uint32_t)size;
+        last_ns = time_ns;
+        if (rec->connection >= connections) {
+            connections = rec->connection + 1;
+        }
+        records++;
+        if (buffered == TRACE_RECORD_BUFFER) {
+            if (write_all(out_fd, buffer, buffered * sizeof(*buffer)) == -1) {
+                perror("write trace");
+                free(buffer);
+                return -1;
+            }
+            buffered = 0;
+        }
+    }
+    if (buffered > 0 && write_all(out_fd, buffer, buffered * sizeof(*buffer)) == -1) {
+        perror("write trace");
+        free(buffer);
+        return -1;
+    }
+    free(buffer);
+
+    trace_header_init(&header, connections);
+    if (pwrite(out_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        perror("write trace header");
+        return -1;
+    }
+    printf("Converted %lu records from %u connection(s)\n", records, connections);
+    return 0;
+}
+
+static int trace_binary_to_csv(const char *in_path, FILE *out) {
+    void *map;
+    size_t map_len;
+    uint32_t connections;
+    long count = trace_map(in_path, &map, &map_len, &connections);
+    if (count < 0) {
+        return -1;
+    }
+
+    const trace_record_t *records = (const trace_record_t *)((const char *)map + sizeof(trace_header_t));
+    fprintf(out, "time_us,connection,size\n");
+    for (long i = 0; i < count; i++) {
+        fprintf(out, "%.3f,%u,%u\n", records[i].time_ns / 1e3, records[i].connection, records[i].size);
+    }
+    munmap(map, map_len);
+    printf("Converted %ld records from %u connection(s)\n", count, connections);
+    return 0;
+}
+
+static int has_csv_suffix(const char *path) {
+    size_t len = strlen(path);
+    return len >= 4 && strcmp(path + len - 4, ".csv") == 0;
+}
+
+// --trace-convert <in> <out>: CSV to binary, or binary to CSV when the
+// output name ends in .csv
+int trace_convert(const char *in_path, const char *out_path) {
+    int rc;
+
+    if (has_csv_suffix(out_path)) {
+        FILE *out = fopen(out_path, "w");
+        if (!out) {
+            fprintf(stderr, "Error: Cannot create '%s': %s\n", out_path, strerror(errno));
+            return -1;
+        }
+        rc = trace_binary_to_csv(in_path, out);
+        if (fclose(out) != 0) {
+            rc = -1;
+        }
+        return rc;
+    }
+
+    FILE *in = fopen(in_path, "r");
+    if (!in) {
+        fprintf(stderr, "Error: Cannot open '%s': %s\n", in_path, strerror(errno));
+        return -1;
+    }
+    int out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd == -1) {
+        fprintf(stderr, "Error: Cannot create '%s': %s\n", out_path, strerror(errno));
+        fclose(in);
+        return -1;
+    }
+    rc = trace_csv_to_binary(in, out_fd);
+    close(out_fd);
+    fclose(in);
+    return rc;
+}
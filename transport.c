@@ -0,0 +1,141 @@
+#include "network_app.h"
+
+// Transport abstraction: maps the configured address (-i) and port onto the
+// socket family and sockaddr used by both the server listener and the client
+// connector, so the same workload can run over IPv4, IPv6 or Unix sockets.
+
+int transport_parse(const char *name) {
+    if (strcmp(name, "inet") == 0 || strcmp(name, "ipv4") == 0) {
+        return TRANSPORT_INET;
+    } else if (strcmp(name, "inet6") == 0 || strcmp(name, "ipv6") == 0) {
+        return TRANSPORT_INET6;
+    } else if (strcmp(name, "unix") == 0) {
+        return TRANSPORT_UNIX;
+    }
+    return -1;
+}
+
+int transport_detect(const char *address) {
+    if (address[0] == '/' || address[0] == '@') {
+        return TRANSPORT_UNIX;
+    }
+    if (strchr(address, ':') != NULL) {
+        return TRANSPORT_INET6;
+    }
+    return TRANSPORT_INET;
+}
+
+const char *transport_name(int transport) {
+    switch (transport) {
+        case TRANSPORT_INET:  return "inet";
+        case TRANSPORT_INET6: return "inet6";
+        case TRANSPORT_UNIX:
+            return g_ctx.listen_ip[0] == '@' ? "unix-abstract" : "unix";
+        default:              return "unknown";
+    }
+}
+
+int transport_family(void) {
+    switch (g_ctx.transport) {
+        case TRANSPORT_INET6: return AF_INET6;
+        case TRANSPORT_UNIX:  return AF_UNIX;
+        default:              return AF_INET;
+    }
+}
+
+int transport_is_ip(void) {
+    return g_ctx.transport == TRANSPORT_INET || g_ctx.transport == TRANSPORT_INET6;
+}
+
+// Unix sockets have no ports, so each thread gets its own path with the
+// port number appended: "<path>.<port>". A leading '@' selects the Linux
+// abstract namespace (sun_path[0] == '\0'), which needs no unlink.
+static int unix_path_for_port(int port, char *buf, size_t len) {
+    const char *base = g_ctx.listen_ip[0] == '@' ? g_ctx.listen_ip + 1 : g_ctx.listen_ip;
+    int n = snprintf(buf, len, "%s.%d", base, port);
+    if (n < 0 || (size_t)n >= len) {
+        return -1;
+    }
+    return n;
+}
+
+int transport_build_address(int port, struct sockaddr_storage *addr, socklen_t *addr_len) {
+    memset(addr, 0, sizeof(*addr));
+
+    switch (g_ctx.transport) {
+        case TRANSPORT_INET: {
+            struct sockaddr_in *sin = (struct sockaddr_in *)addr;
+            sin->sin_family = AF_INET;
+            sin->sin_port = htons(port);
+            if (inet_pton(AF_INET, g_ctx.listen_ip, &sin->sin_addr) != 1) {
+                return -1;
+            }
+            *addr_len = sizeof(*sin);
+            return 0;
+        }
+        case TRANSPORT_INET6: {
+            struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)addr;
+            sin6->sin6_family = AF_INET6;
+            sin6->sin6_port = htons(port);
+            if (inet_pton(AF_INET6, g_ctx.listen_ip, &sin6->sin6_addr) != 1) {
+                return -1;
+            }
+            *addr_len = sizeof(*sin6);
+            return 0;
+        }
+        case TRANSPORT_UNIX: {
+            struct sockaddr_un *sun = (struct sockaddr_un *)addr;
+            int abstract = g_ctx.listen_ip[0] == '@';
+            sun->sun_family = AF_UNIX;
+            // Abstract names start after the leading NUL byte
+            int n = unix_path_for_port(port, sun->sun_path + abstract,
+                                       sizeof(sun->sun_path) - abstract);
+            if (n < 0) {
+                return -1;
+            }
+            *addr_len = offsetof(struct sockaddr_un, sun_path) + abstract + n;
+            if (!abstract) {
+                *addr_len += 1; // Include the terminating NUL for filesystem paths
+            }
+            return 0;
+        }
+        default:
+            return -1;
+    }
+}
+
+int transport_create_socket(int sock_type) {
+    return socket(transport_family(), sock_type, 0);
+}
+
+void transport_format_endpoint(int port, char *buf, size_t len) {
+    switch (g_ctx.transport) {
+        case TRANSPORT_INET6:
+            snprintf(buf, len, "[%s]:%d", g_ctx.listen_ip, port);
+            break;
+        case TRANSPORT_UNIX: {
+            char path[MAX_ADDRESS_LEN];
+            if (unix_path_for_port(port, path, sizeof(path)) < 0) {
+                snprintf(buf, len, "%s.%d", g_ctx.listen_ip, port);
+            } else {
+                snprintf(buf, len, "%s%s", g_ctx.listen_ip[0] == '@' ? "@" : "", path);
+            }
+            break;
+        }
+        default:
+            snprintf(buf, len, "%s:%d", g_ctx.listen_ip, port);
+            break;
+    }
+}
+
+void transport_unlink(int port) {
+    // Only filesystem Unix sockets leave a node behind
+    if (g_ctx.transport != TRANSPORT_UNIX || g_ctx.listen_ip[0] == '@') {
+        return;
+    }
+
+    char path[MAX_ADDRESS_LEN];
+    if (unix_path_for_port(port, path, sizeof(path)) >= 0) {
+        unlink(path);
+    }
+}
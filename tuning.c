@@ -0,0 +1,190 @@
+#include "network_app.h"
+
+// Socket tuning profiles: a named preset of socket options applied the same
+// way to listen, accepted and client sockets. Values of -1 leave the kernel
+// default untouched. Individual --nodelay/--sndbuf/... flags override the
+// selected profile, and the effective values are read back with getsockopt()
+// from the first socket of each role so runs can be compared.
+
+static const socket_tuning_t tuning_profile_default = {
+    .nodelay = -1, .quickack = -1, .busy_poll_usec = -1,
+    .sndbuf = -1, .rcvbuf = -1, .notsent_lowat = -1, .cork = -1,
+    .prefer_busy_poll = -1
+};
+
+// Small messages: disable Nagle and delayed ACKs, busy-poll the NIC queue and
+// keep little unsent data queued so writes reflect the real send backlog
+static const socket_tuning_t tuning_profile_latency = {
+    .nodelay = 1, .quickack = 1, .busy_poll_usec = 50,
+    .sndbuf = -1, .rcvbuf = -1, .notsent_lowat = 16384, .cork = 0,
+    .prefer_busy_poll = -1
+};
+
+// Bulk transfer: large socket buffers so the window is not buffer-limited
+static const socket_tuning_t tuning_profile_throughput = {
+    .nodelay = 0, .quickack = -1, .busy_poll_usec = -1,
+    .sndbuf = 4 * 1024 * 1024, .rcvbuf = 4 * 1024 * 1024, .notsent_lowat = -1, .cork = -1,
+    .prefer_busy_poll = -1
+};
+
+static const char *tuning_role_names[TUNING_ROLE_COUNT] = { "listen", "accepted", "client" };
+
+// Each option only warns once per process instead of once per socket
+static volatile int tuning_warned_mask = 0;
+
+void tuning_init_overrides(void) {
+    g_ctx.tuning_profile = TUNING_PROFILE_DEFAULT;
+    g_ctx.tuning_override = tuning_profile_default;
+}
+
+int tuning_parse_profile(const char *name) {
+    if (strcmp(name, "default") == 0) {
+        return TUNING_PROFILE_DEFAULT;
+    } else if (strcmp(name, "latency") == 0) {
+        return TUNING_PROFILE_LATENCY;
+    } else if (strcmp(name, "throughput") == 0) {
+        return TUNING_PROFILE_THROUGHPUT;
+    } else if (strcmp(name, "custom") == 0) {
+        return TUNING_PROFILE_CUSTOM;
+    }
+    return -1;
+}
+
+const char *tuning_profile_name(int profile) {
+    switch (profile) {
+        case TUNING_PROFILE_DEFAULT:    return "default";
+        case TUNING_PROFILE_LATENCY:    return "latency";
+        case TUNING_PROFILE_THROUGHPUT: return "throughput";
+        case TUNING_PROFILE_CUSTOM:     return "custom";
+        default:                        return "unknown";
+    }
+}
+
+void tuning_resolve(void) {
+    const socket_tuning_t *base;
+    int overridden = 0;
+
+    switch (g_ctx.tuning_profile) {
+        case TUNING_PROFILE_LATENCY:    base = &tuning_profile_latency; break;
+        case TUNING_PROFILE_THROUGHPUT: base = &tuning_profile_throughput; break;
+        default:                        base = &tuning_profile_default; break;
+    }
+    g_ctx.tuning = *base;
+
+#define TUNING_MERGE(field) \
+    if (g_ctx.tuning_override.field != -1) { g_ctx.tuning.field = g_ctx.tuning_override.field; overridden = 1; }
+    TUNING_MERGE(nodelay);
+    TUNING_MERGE(quickack);
+    TUNING_MERGE(busy_poll_usec);
+    TUNING_MERGE(sndbuf);
+    TUNING_MERGE(rcvbuf);
+    TUNING_MERGE(notsent_lowat);
+    TUNING_MERGE(cork);
+    TUNING_MERGE(prefer_busy_poll);
+#undef TUNING_MERGE
+
+    // Any explicit option turns a named profile into a custom one
+    if (overridden) {
+        g_ctx.tuning_profile = TUNING_PROFILE_CUSTOM;
+    }
+}
+
+static void tuning_setsockopt(int fd, int level, int option, const char *name, int bit, int value) {
+    if (value < 0) {
+        return;
+    }
+    if (setsockopt(fd, level, option, &value, sizeof(value)) == -1) {
+        int err = errno;
+        if (!(__sync_fetch_and_or(&tuning_warned_mask, bit) & bit)) {
+            fprintf(stderr, "Warning: setsockopt(%s=%d) failed: %s\n", name, value, strerror(err));
+        }
+    }
+}
+
+void tuning_apply(int fd, tuning_role_t role) {
+    const socket_tuning_t *t = &g_ctx.tuning;
+
+    // Buffer sizes must be in place before listen()/connect() so the
+    // window scale negotiated in the handshake can use them
+    tuning_setsockopt(fd, SOL_SOCKET, SO_SNDBUF, "SO_SNDBUF", 1 << 0, t->sndbuf);
+    tuning_setsockopt(fd, SOL_SOCKET, SO_RCVBUF, "SO_RCVBUF", 1 << 1, t->rcvbuf);
+
+    // The remaining options are TCP/IP specific
+    if (!transport_is_ip()) {
+        return;
+    }
+
+    tuning_setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, "SO_BUSY_POLL", 1 << 2, t->busy_poll_usec);
+    tuning_setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, "SO_PREFER_BUSY_POLL", 1 << 7, t->prefer_busy_poll);
+    if (g_ctx.udp) {
+        return;
+    }
+    tuning_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, "TCP_NODELAY", 1 << 3, t->nodelay);
+    tuning_setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, "TCP_NOTSENT_LOWAT", 1 << 4, t->notsent_lowat);
+    if (role != TUNING_ROLE_LISTENER) {
+        tuning_setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, "TCP_QUICKACK", 1 << 5, t->quickack);
+        tuning_setsockopt(fd, IPPROTO_TCP, TCP_CORK, "TCP_CORK", 1 << 6, t->cork);
+    }
+}
+
+void tuning_rearm_quickack(int fd) {
+    // TCP_QUICKACK is not sticky: the kernel may fall back to delayed ACKs
+    // after any read, so it has to be set again after each one
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+}
+
+void tuning_cork(int fd, int on) {
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+}
+
+void tuning_nodelay(int fd, int on) {
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+static int tuning_getsockopt(int fd, int level, int option) {
+    int value = -1;
+    socklen_t len = sizeof(value);
+    if (getsockopt(fd, level, option, &value, &len) == -1) {
+        return -1;
+    }
+    return value;
+}
+
+void tuning_report(int fd, tuning_role_t role) {
+    // Report only the first socket of each role
+    if (__sync_lock_test_and_set(&g_ctx.tuning_reported[role], 1)) {
+        return;
+    }
+
+    socket_tuning_t *eff = &g_ctx.tuning_effective[role];
+    *eff = tuning_profile_default;
+    eff->sndbuf = tuning_getsockopt(fd, SOL_SOCKET, SO_SNDBUF);
+    eff->rcvbuf = tuning_getsockopt(fd, SOL_SOCKET, SO_RCVBUF);
+    if (transport_is_ip()) {
+        eff->busy_poll_usec = tuning_getsockopt(fd, SOL_SOCKET, SO_BUSY_POLL);
+        eff->prefer_busy_poll = tuning_getsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL);
+    }
+    if (transport_is_ip() && !g_ctx.udp) {
+        eff->nodelay = tuning_getsockopt(fd, IPPROTO_TCP, TCP_NODELAY);
+        eff->quickack = tuning_getsockopt(fd, IPPROTO_TCP, TCP_QUICKACK);
+        eff->notsent_lowat = tuning_getsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+        eff->cork = tuning_getsockopt(fd, IPPROTO_TCP, TCP_CORK);
+    }
+
+    printf("Socket tuning [%s] %s socket: ", tuning_profile_name(g_ctx.tuning_profile),
+           tuning_role_names[role]);
+    tuning_print_values(stdout, eff);
+    printf("\n");
+}
+
+void tuning_print_values(FILE *out, const socket_tuning_t *t) {
+    fprintf(out, "SO_SNDBUF=%d SO_RCVBUF=%d", t->sndbuf, t->rcvbuf);
+    if (transport_is_ip() && g_ctx.udp) {
+        fprintf(out, " SO_BUSY_POLL=%d SO_PREFER_BUSY_POLL=%d", t->busy_poll_usec, t->prefer_busy_poll);
+    } else if (transport_is_ip()) {
+        fprintf(out, " TCP_NODELAY=%d TCP_QUICKACK=%d SO_BUSY_POLL=%d SO_PREFER_BUSY_POLL=%d"
+                " TCP_NOTSENT_LOWAT=%d TCP_CORK=%d", t->nodelay, t->quickack, t->busy_poll_usec,
+                t->prefer_busy_poll, t->notsent_lowat, t->cork);
+    }
+}
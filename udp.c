@@ -0,0 +1,746 @@
+#include "network_app.h"
+
+// UDP echo mode. Each server thread owns one UDP socket on its port and
+// echoes datagrams back to their sender in recvmmsg()/sendmmsg() batches.
+// With --gro the kernel may coalesce consecutive datagrams from one sender
+// into a single receive (segment size in a UDP_GRO control message); the
+// echo then leaves as one UDP_SEGMENT (GSO) send with --gso, or is split
+// back into individual datagrams without it.
+//
+// The client keeps one connected UDP socket per port. Every datagram starts
+// with a 16-byte header that the server echoes untouched:
+//   uint64_t sequence;   (per socket, starting at 1)
+//   uint64_t send_ns;    (client CLOCK_MONOTONIC)
+// which yields per-datagram RTT, loss and reordering with no server state.
+// At most --udp-window datagrams are in flight per socket; datagrams still
+// unanswered after UDP_LOSS_TIMEOUT_MS count as lost.
+
+// Room for one UDP_GRO (int) or UDP_SEGMENT (uint16_t) control message
+#define UDP_CONTROL_SIZE CMSG_SPACE(sizeof(int))
+
+// Payload after the header; the content is irrelevant
+static char udp_fill[UDP_MAX_DATAGRAM];
+
+// recvmmsg()/sendmmsg() vectors, allocated once per event loop
+typedef struct {
+    struct mmsghdr *rx_msgs;
+    struct iovec *rx_iov;
+    struct sockaddr_storage *rx_addr;
+    char *rx_buffers;
+    char *rx_control;
+    size_t rx_buffer_size;
+    struct mmsghdr *tx_msgs;
+    struct iovec *tx_iov;
+    char *tx_control;
+    uint64_t *tx_headers;          // Client: sequence + timestamp per datagram
+    int tx_capacity;               // Messages
+    int tx_segments;               // Client: datagrams per message (GSO)
+} udp_batch_t;
+
+static void *udp_calloc(size_t count, size_t size) {
+    void *p = calloc(count, size);
+    if (!p) {
+        perror("calloc");
+        exit(1);
+    }
+    return p;
+}
+
+static void udp_batch_init(udp_batch_t *b, size_t rx_buffer_size, int tx_capacity, int tx_segments) {
+    int batch = g_ctx.udp_batch;
+
+    b->rx_msgs = udp_calloc(batch, sizeof(*b->rx_msgs));
+    b->rx_iov = udp_calloc(batch, sizeof(*b->rx_iov));
+    b->rx_addr = udp_calloc(batch, sizeof(*b->rx_addr));
+    b->rx_buffers = udp_calloc(batch, rx_buffer_size);
+    b->rx_control = udp_calloc(batch, UDP_CONTROL_SIZE);
+    b->rx_buffer_size = rx_buffer_size;
+    b->tx_msgs = udp_calloc(tx_capacity, sizeof(*b->tx_msgs));
+    b->tx_iov = udp_calloc((size_t)tx_capacity * tx_segments * 2, sizeof(*b->tx_iov));
+    b->tx_control = udp_calloc(tx_capacity, UDP_CONTROL_SIZE);
+    b->tx_headers = udp_calloc((size_t)tx_capacity * tx_segments * 2, sizeof(uint64_t));
+    b->tx_capacity = tx_capacity;
+    b->tx_segments = tx_segments;
+}
+
+static void udp_batch_free(udp_batch_t *b) {
+    free(b->rx_msgs);
+    free(b->rx_iov);
+    free(b->rx_addr);
+    free(b->rx_buffers);
+    free(b->rx_control);
+    free(b->tx_msgs);
+    free(b->tx_iov);
+    free(b->tx_control);
+    free(b->tx_headers);
+}
+
+// Receive up to one batch; returns the number of messages, 0 if none
+static int udp_batch_receive(int fd, udp_batch_t *b) {
+    int batch = g_ctx.udp_batch;
+
+    for (int i = 0; i < batch; i++) {
+        struct msghdr *h = &b->rx_msgs[i].msg_hdr;
+        b->rx_iov[i].iov_base = b->rx_buffers + (size_t)i * b->rx_buffer_size;
+        b->rx_iov[i].iov_len = b->rx_buffer_size;
+        h->msg_name = &b->rx_addr[i];
+        h->msg_namelen = sizeof(b->rx_addr[i]);
+        h->msg_iov = &b->rx_iov[i];
+        h->msg_iovlen = 1;
+        h->msg_control = b->rx_control + (size_t)i * UDP_CONTROL_SIZE;
+        h->msg_controllen = UDP_CONTROL_SIZE;
+        h->msg_flags = 0;
+    }
+
+    int n = recvmmsg(fd, b->rx_msgs, batch, MSG_DONTWAIT, NULL);
+    if (n == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            count_socket_error(errno);
+        }
+        return 0;
+    }
+    return n;
+}
+
+// Segment size of a GRO-coalesced receive, or the whole length for a
+// plain datagram
+static size_t udp_segment_size(struct msghdr *h, size_t len, int gro) {
+    if (!gro) {
+        return len;
+    }
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(h); c; c = CMSG_NXTHDR(h, c)) {
+        if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) {
+            int segment;
+            memcpy(&segment, CMSG_DATA(c), sizeof(segment));
+            return segment > 0 && (size_t)segment < len ? (size_t)segment : len;
+        }
+    }
+    return len;
+}
+
+static void udp_set_segment(struct msghdr *h, char *control, uint16_t segment) {
+    h->msg_control = control;
+    h->msg_controllen = CMSG_SPACE(sizeof(segment));
+    struct cmsghdr *c = CMSG_FIRSTHDR(h);
+    c->cmsg_level = SOL_UDP;
+    c->cmsg_type = UDP_SEGMENT;
+    c->cmsg_len = CMSG_LEN(sizeof(segment));
+    memcpy(CMSG_DATA(c), &segment, sizeof(segment));
+}
+
+// Turn a UDP socket option on, disabling the feature with a warning when
+// the kernel does not support it. *feature is either a g_ctx flag (probe,
+// before any thread starts) or a copy owned by the calling thread.
+static void udp_enable_option(int fd, int option, const char *name, int value, int *feature) {
+    if (!*feature) {
+        return;
+    }
+    if (setsockopt(fd, SOL_UDP, option, &value, sizeof(value)) == -1) {
+        fprintf(stderr, "Warning: %s not available (%s), disabled\n", name, strerror(errno));
+        *feature = 0;
+    }
+}
+
+// Probe GSO/GRO support once on a scratch socket, so the shared flags are
+// settled before the server threads or the client sockets read them
+void udp_probe_offloads(void) {
+    if (!g_ctx.udp_gro && !g_ctx.udp_gso) {
+        return;
+    }
+    int fd = transport_create_socket(SOCK_DGRAM);
+    if (fd == -1) {
+        perror("socket");
+        exit(1);
+    }
+    udp_enable_option(fd, UDP_GRO, "UDP_GRO", 1, &g_ctx.udp_gro);
+    // The segment size itself goes with each send (server) or socket (client)
+    udp_enable_option(fd, UDP_SEGMENT, "UDP_SEGMENT", 0, &g_ctx.udp_gso);
+    close(fd);
+}
+
+// Send a whole batch. A full send buffer drops the rest of it, as a
+// congested network would; the client sees the loss and the server counts
+// the drops rather than stalling its event loop.
+static void udp_server_send(server_thread_meta_t *meta, udp_batch_t *b, int count) {
+    int done = 0;
+
+    while (done < count) {
+        int sent = sendmmsg(meta->listen_fd, b->tx_msgs + done, count - done, 0);
+        if (sent > 0) {
+            for (int i = done; i < done + sent; i++) {
+                meta->total_bytes_sent += b->tx_msgs[i].msg_len;
+            }
+            done += sent;
+        } else if (sent == -1 && errno == EINTR) {
+            continue;
+        } else if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            meta->total_tx_drops += (uint64_t)(count - done);
+            break;
+        } else {
+            // Drop the datagram, as the network would
+            count_socket_error(errno);
+            done++;
+        }
+    }
+}
+
+static struct msghdr *udp_server_add_tx(udp_batch_t *b, int *count, struct msghdr *rx, char *data, size_t len) {
+    struct mmsghdr *m = &b->tx_msgs[*count];
+    struct iovec *iov = &b->tx_iov[*count];
+
+    iov->iov_base = data;
+    iov->iov_len = len;
+    memset(&m->msg_hdr, 0, sizeof(m->msg_hdr));
+    m->msg_hdr.msg_name = rx->msg_name;
+    m->msg_hdr.msg_namelen = rx->msg_namelen;
+    m->msg_hdr.msg_iov = iov;
+    m->msg_hdr.msg_iovlen = 1;
+    (*count)++;
+    return &m->msg_hdr;
+}
+
+// Echo one recvmmsg() batch straight out of the receive buffers
+static void udp_server_echo(server_thread_meta_t *meta, udp_batch_t *b) {
+    int n = udp_batch_receive(meta->listen_fd, b);
+    if (n == 0) {
+        return;
+    }
+    meta->total_recv_calls++;
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        struct msghdr *rx = &b->rx_msgs[i].msg_hdr;
+        size_t len = b->rx_msgs[i].msg_len;
+        size_t segment = udp_segment_size(rx, len, meta->udp_gro);
+        char *data = b->rx_iov[i].iov_base;
+
+        meta->total_bytes_received += len;
+        meta->total_frames += len == 0 ? 1 : (len + segment - 1) / segment;
+
+        if (segment == len || meta->udp_gso) {
+            struct msghdr *tx = udp_server_add_tx(b, &count, rx, data, len);
+            if (segment < len) {
+                udp_set_segment(tx, b->tx_control + (size_t)(count - 1) * UDP_CONTROL_SIZE, (uint16_t)segment);
+            }
+        } else {
+            // Coalesced on receive but no GSO: one datagram per segment
+            for (size_t offset = 0; offset < len; offset += segment) {
+                if (count == b->tx_capacity) {
+                    udp_server_send(meta, b, count);
+                    count = 0;
+                }
+                size_t part = len - offset < segment ? len - offset : segment;
+                udp_server_add_tx(b, &count, rx, data + offset, part);
+            }
+        }
+        if (count == b->tx_capacity) {
+            udp_server_send(meta, b, count);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        udp_server_send(meta, b, count);
+    }
+}
+
+void *udp_server_thread_func(void *arg) {
+    server_thread_meta_t *meta = (server_thread_meta_t *)arg;
+    struct sockaddr_storage server_addr;
+    socklen_t server_len;
+    char endpoint[MAX_ADDRESS_LEN + 16];
+    struct epoll_event event, events[2];
+    udp_batch_t batch;
+
+    meta->listen_fd = transport_create_socket(SOCK_DGRAM);
+    if (meta->listen_fd == -1) {
+        perror("socket");
+        exit(1);
+    }
+    tuning_apply(meta->listen_fd, TUNING_ROLE_LISTENER);
+    tuning_report(meta->listen_fd, TUNING_ROLE_LISTENER);
+    meta->udp_gro = g_ctx.udp_gro;
+    meta->udp_gso = g_ctx.udp_gso;
+    udp_enable_option(meta->listen_fd, UDP_GRO, "UDP_GRO", 1, &meta->udp_gro);
+    // The segment size itself goes with each send
+    udp_enable_option(meta->listen_fd, UDP_SEGMENT, "UDP_SEGMENT", 0, &meta->udp_gso);
+
+    if (set_socket_nonblocking(meta->listen_fd) == -1) {
+        exit(1);
+    }
+    if (transport_build_address(meta->port, &server_addr, &server_len) == -1) {
+        fprintf(stderr, "Invalid listen address '%s'\n", g_ctx.listen_ip);
+        exit(1);
+    }
+    if (bind(meta->listen_fd, (struct sockaddr *)&server_addr, server_len) == -1) {
+        perror("bind");
+        exit(1);
+    }
+
+    meta->epoll_fd = epoll_create1(0);
+    if (meta->epoll_fd == -1) {
+        perror("epoll_create1");
+        exit(1);
+    }
+    event.events = EPOLLIN;
+    event.data.fd = meta->listen_fd;
+    if (epoll_ctl(meta->epoll_fd, EPOLL_CTL_ADD, meta->listen_fd, &event) == -1) {
+        perror("epoll_ctl add udp socket");
+        exit(1);
+    }
+    event.events = EPOLLIN;
+    event.data.fd = g_ctx.shutdown_fd;
+    if (epoll_ctl(meta->epoll_fd, EPOLL_CTL_ADD, g_ctx.shutdown_fd, &event) == -1) {
+        perror("epoll_ctl add shutdown eventfd");
+        exit(1);
+    }
+
+    // Splitting a GRO receive without GSO needs one message per segment
+    int tx_capacity = meta->udp_gro && !meta->udp_gso ? g_ctx.udp_batch * UDP_MAX_SEGMENTS : g_ctx.udp_batch;
+    udp_batch_init(&batch, UDP_RX_BUFFER_SIZE, tx_capacity, 1);
+
+    transport_format_endpoint(meta->port, endpoint, sizeof(endpoint));
+    printf("Server thread %d listening on %s (%s, UDP)\n", meta->thread_index, endpoint,
+           transport_name(g_ctx.transport));
+
+    uint64_t drain_deadline_ms = 0;
+    while (g_ctx.running) {
+        // While draining, a short quiet period means no echo is in flight
+        int nfds = loop_wait(&meta->loop, meta->epoll_fd, events, 2, drain_deadline_ms ? 10 : 100);
+        if (nfds == -1) {
+            if (errno != EINTR) {
+                perror("epoll_wait");
+                exit(1);
+            }
+            continue;
+        }
+
+        // Warm-up ended: event loop statistics start over
+        if (meta->stats_epoch != g_ctx.server_stats_epoch) {
+            meta->stats_epoch = g_ctx.server_stats_epoch;
+            loop_stats_reset(&meta->loop);
+        }
+
+        int datagram_events = 0;
+        for (int i = 0; i < nfds; i++) {
+            if (events[i].data.fd == meta->listen_fd) {
+                udp_server_echo(meta, &batch);
+                datagram_events++;
+            }
+        }
+
+        if (g_ctx.shutdown_requested) {
+            uint64_t now_ms = now_monotonic_ms();
+            if (drain_deadline_ms == 0) {
+                epoll_ctl(meta->epoll_fd, EPOLL_CTL_DEL, g_ctx.shutdown_fd, NULL);
+                drain_deadline_ms = now_ms + g_ctx.drain_timeout_ms;
+            } else if (datagram_events == 0 || now_ms >= drain_deadline_ms) {
+                break;
+            }
+        }
+    }
+
+    udp_batch_free(&batch);
+    close(meta->listen_fd);
+    meta->listen_fd = -1;
+    close(meta->epoll_fd);
+    return NULL;
+}
+
+// Client
+
+static udp_batch_t client_batch;
+
+static void udp_client_set_events(client_connection_meta_t *conn, uint32_t events) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.ptr = conn;
+    epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_MOD, conn->socket_fd, &event);
+}
+
+static void udp_client_connect(client_connection_meta_t *conn) {
+    struct sockaddr_storage server_addr;
+    socklen_t server_len;
+
+    conn->socket_fd = transport_create_socket(SOCK_DGRAM);
+    if (conn->socket_fd == -1) {
+        printf("CLIENT: socket() failed for connection %d: %s\n", conn->thread_index, strerror(errno));
+        exit(1);
+    }
+    if (set_socket_nonblocking(conn->socket_fd) == -1) {
+        printf("CLIENT: Failed to set socket non-blocking for connection %d\n", conn->thread_index);
+        exit(1);
+    }
+    tuning_apply(conn->socket_fd, TUNING_ROLE_CLIENT);
+    udp_enable_option(conn->socket_fd, UDP_GRO, "UDP_GRO", 1, &g_ctx.udp_gro);
+    // Every send larger than one datagram is split by the kernel (GSO)
+    udp_enable_option(conn->socket_fd, UDP_SEGMENT, "UDP_SEGMENT", g_ctx.datagram_size, &g_ctx.udp_gso);
+
+    if (transport_build_address(conn->port, &server_addr, &server_len) == -1) {
+        printf("CLIENT: Invalid connect address '%s' for connection %d\n", g_ctx.listen_ip, conn->thread_index);
+        exit(1);
+    }
+    // A connected UDP socket only receives from the server and needs no
+    // address per send
+    if (connect(conn->socket_fd, (struct sockaddr *)&server_addr, server_len) == -1) {
+        printf("CLIENT: connect() failed for connection %d: %s\n", conn->thread_index, strerror(errno));
+        exit(1);
+    }
+    tuning_report(conn->socket_fd, TUNING_ROLE_CLIENT);
+
+    conn->is_connected = 1;
+    conn->udp.next_seq = 1;
+    conn->udp.highest_seq = 0;
+    conn->udp.last_progress_ns = now_monotonic_ns();
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = conn;
+    if (epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_ADD, conn->socket_fd, &event) == -1) {
+        perror("epoll_ctl add client socket");
+        exit(1);
+    }
+}
+
+static uint64_t udp_flow_in_flight(const udp_flow_t *f) {
+    return f->next_seq - 1 - f->highest_seq;
+}
+
+// Fill the window: sequence numbers and timestamps go into per-datagram
+// headers, payloads all point at the shared fill buffer
+static void udp_client_send(client_connection_meta_t *conn) {
+    udp_batch_t *b = &client_batch;
+    udp_flow_t *f = &conn->udp;
+    uint64_t in_flight = udp_flow_in_flight(f);
+
+    if (f->blocked || in_flight >= (uint64_t)g_ctx.udp_window) {
+        return;
+    }
+    uint64_t budget = g_ctx.udp_window - in_flight;
+    uint64_t now_ns = now_monotonic_ns();
+    if (in_flight == 0) {
+        f->last_progress_ns = now_ns;
+    }
+
+    int msgs = 0;
+    size_t datagram = 0;
+    uint64_t seq = f->next_seq;
+    while (msgs < b->tx_capacity && budget > 0) {
+        int segments = budget < (uint64_t)b->tx_segments ? (int)budget : b->tx_segments;
+        struct msghdr *h = &b->tx_msgs[msgs].msg_hdr;
+        memset(h, 0, sizeof(*h));
+        h->msg_iov = &b->tx_iov[datagram * 2];
+        h->msg_iovlen = segments * 2;
+        for (int s = 0; s < segments; s++, datagram++, seq++) {
+            uint64_t *header = &b->tx_headers[datagram * 2];
+            header[0] = seq;
+            header[1] = now_ns;
+            b->tx_iov[datagram * 2].iov_base = header;
+            b->tx_iov[datagram * 2].iov_len = UDP_HEADER_SIZE;
+            b->tx_iov[datagram * 2 + 1].iov_base = udp_fill;
+            b->tx_iov[datagram * 2 + 1].iov_len = g_ctx.datagram_size - UDP_HEADER_SIZE;
+        }
+        msgs++;
+        budget -= segments;
+    }
+
+    int sent = sendmmsg(conn->socket_fd, b->tx_msgs, msgs, 0);
+    if (sent == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            f->blocked = 1;
+            udp_client_set_events(conn, EPOLLIN | EPOLLOUT);
+        } else {
+            count_socket_error(errno); // e.g. ECONNREFUSED reported by an earlier ICMP
+        }
+        return;
+    }
+    for (int i = 0; i < sent; i++) {
+        uint64_t datagrams = b->tx_msgs[i].msg_hdr.msg_iovlen / 2;
+        f->next_seq += datagrams;
+        f->packets_sent += datagrams;
+        conn->total_bytes_sent += b->tx_msgs[i].msg_len;
+    }
+    if (sent < msgs) {
+        f->blocked = 1;
+        udp_client_set_events(conn, EPOLLIN | EPOLLOUT);
+    }
+}
+
+static void udp_flow_ack(client_connection_meta_t *conn, const char *data, uint64_t now_ns) {
+    udp_flow_t *f = &conn->udp;
+    uint64_t seq, sent_ns;
+
+    memcpy(&seq, data, sizeof(seq));
+    memcpy(&sent_ns, data + sizeof(seq), sizeof(sent_ns));
+    if (seq == 0 || seq >= f->next_seq) {
+        g_ctx.errors_other++; // Not a datagram this socket sent
+        return;
+    }
+
+    f->packets_received++;
+    f->rtt_sum_ns += now_ns - sent_ns;
+    histogram_record(&g_ctx.client_latency, now_ns - sent_ns);
+    if (seq > f->highest_seq) {
+        // Anything skipped over is lost unless it turns up later
+        f->packets_lost += seq - f->highest_seq - 1;
+        f->highest_seq = seq;
+    } else {
+        f->packets_reordered++;
+        if (f->packets_lost > 0) {
+            f->packets_lost--;
+        }
+    }
+    f->last_progress_ns = now_ns;
+}
+
+static void udp_client_receive(client_connection_meta_t *conn, uint64_t *bytes_received_total) {
+    udp_batch_t *b = &client_batch;
+    int n = udp_batch_receive(conn->socket_fd, b);
+    uint64_t now_ns = now_monotonic_ns();
+
+    for (int i = 0; i < n; i++) {
+        size_t len = b->rx_msgs[i].msg_len;
+        size_t segment = udp_segment_size(&b->rx_msgs[i].msg_hdr, len, g_ctx.udp_gro);
+        const char *data = b->rx_iov[i].iov_base;
+
+        for (size_t offset = 0; offset + UDP_HEADER_SIZE <= len; offset += segment) {
+            udp_flow_ack(conn, data + offset, now_ns);
+        }
+        conn->total_bytes_received += len;
+        *bytes_received_total += len;
+    }
+}
+
+// Datagrams still unanswered after the loss timeout are written off, which
+// also reopens the window
+static void udp_flow_expire(udp_flow_t *f, uint64_t now_ns) {
+    uint64_t in_flight = udp_flow_in_flight(f);
+    if (in_flight > 0 && now_ns - f->last_progress_ns >= UDP_LOSS_TIMEOUT_MS * 1000000ULL) {
+        f->packets_lost += in_flight;
+        f->highest_seq = f->next_seq - 1;
+        f->last_progress_ns = now_ns;
+    }
+}
+
+// Warm-up is over: restart the counters, keeping sequence state so echoes
+// of warm-up datagrams are still matched
+static void udp_reset_counters(void) {
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        client_connection_meta_t *conn = &g_ctx.client_connections[i];
+        conn->total_bytes_sent = 0;
+        conn->total_bytes_received = 0;
+        conn->udp.packets_sent = 0;
+        conn->udp.packets_received = 0;
+        conn->udp.packets_lost = 0;
+        conn->udp.packets_reordered = 0;
+        conn->udp.rtt_sum_ns = 0;
+    }
+    g_ctx.errors_connection = 0;
+    g_ctx.errors_io = 0;
+    g_ctx.errors_system = 0;
+    g_ctx.errors_other = 0;
+    histogram_reset(&g_ctx.client_latency);
+    loop_stats_reset(&g_ctx.client_loop);
+}
+
+int run_udp_client(void) {
+    printf("Starting %s UDP client with %d sockets to %s ports %d-%d\n",
+           transport_name(g_ctx.transport), g_ctx.num_threads, g_ctx.listen_ip,
+           g_ctx.listen_port_start, g_ctx.listen_port_start + g_ctx.num_threads - 1);
+
+    g_ctx.client_connections = calloc(g_ctx.num_threads, sizeof(client_connection_meta_t));
+    if (!g_ctx.client_connections) {
+        perror("calloc");
+        exit(1);
+    }
+    g_ctx.client_epoll_fd = epoll_create1(0);
+    if (g_ctx.client_epoll_fd == -1) {
+        perror("epoll_create1");
+        exit(1);
+    }
+    memset(udp_fill, 0xAA, sizeof(udp_fill));
+    udp_probe_offloads();
+
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        g_ctx.client_connections[i].thread_index = i;
+        g_ctx.client_connections[i].port = g_ctx.listen_port_start + i;
+        udp_client_connect(&g_ctx.client_connections[i]);
+    }
+
+    // Sizes depend on whether GSO/GRO survived the first socket
+    int segments = 1;
+    if (g_ctx.udp_gso) {
+        segments = UDP_MAX_DATAGRAM / g_ctx.datagram_size;
+        if (segments > UDP_MAX_SEGMENTS) {
+            segments = UDP_MAX_SEGMENTS;
+        }
+        if (segments < 1) {
+            segments = 1;
+        }
+    }
+    size_t rx_size = g_ctx.udp_gro ? UDP_RX_BUFFER_SIZE : (size_t)g_ctx.datagram_size;
+    udp_batch_init(&client_batch, rx_size, g_ctx.udp_batch, segments);
+
+    struct epoll_event shutdown_event;
+    shutdown_event.events = EPOLLIN;
+    shutdown_event.data.ptr = NULL;
+    if (epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_ADD, g_ctx.shutdown_fd, &shutdown_event) == -1) {
+        perror("epoll_ctl add shutdown eventfd");
+        exit(1);
+    }
+
+    int draining = 0;
+    uint64_t drain_deadline_ms = 0;
+    uint64_t bytes_received_total = 0;
+    struct epoll_event events[MAX_EVENTS];
+    time_t last_stats_time = time(NULL);
+    int stats_lines = 0;
+    loop_stats_t last_loop = {0};
+
+    printf("Client started, %d-byte datagrams, window %d per socket\n", g_ctx.datagram_size, g_ctx.udp_window);
+
+    while (g_ctx.running) {
+        // Short timeout so lost tails are detected and the window refilled
+        int nfds = loop_wait(&g_ctx.client_loop, g_ctx.client_epoll_fd, events, MAX_EVENTS, 10);
+        if (nfds == -1) {
+            if (errno != EINTR) {
+                perror("epoll_wait");
+                exit(1);
+            }
+            continue;
+        }
+
+        for (int i = 0; i < nfds; i++) {
+            client_connection_meta_t *conn = (client_connection_meta_t *)events[i].data.ptr;
+            if (conn == NULL) {
+                continue; // Shutdown eventfd
+            }
+            if (events[i].events & EPOLLOUT) {
+                conn->udp.blocked = 0;
+                udp_client_set_events(conn, EPOLLIN);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR)) {
+                udp_client_receive(conn, &bytes_received_total);
+            }
+        }
+
+        uint64_t now_ns = now_monotonic_ns();
+        int in_flight = 0;
+        for (int i = 0; i < g_ctx.num_threads; i++) {
+            client_connection_meta_t *conn = &g_ctx.client_connections[i];
+            udp_flow_expire(&conn->udp, now_ns);
+            if (!draining) {
+                udp_client_send(conn);
+            }
+            in_flight += udp_flow_in_flight(&conn->udp) > 0;
+        }
+
+        // Graceful shutdown: stop sending and wait for the echoes in flight
+        if (g_ctx.shutdown_requested && !draining) {
+            draining = 1;
+            epoll_ctl(g_ctx.client_epoll_fd, EPOLL_CTL_DEL, g_ctx.shutdown_fd, NULL);
+            drain_deadline_ms = now_monotonic_ms() + g_ctx.drain_timeout_ms;
+        }
+        if (draining && (in_flight == 0 || now_monotonic_ms() >= drain_deadline_ms)) {
+            break;
+        }
+
+        if (measure_active() && !draining) {
+            int event = measure_tick(bytes_received_total);
+            if (event == MEASURE_EVENT_STARTED) {
+                udp_reset_counters();
+                g_ctx.run_start_ns = now_monotonic_ns();
+                printf("MEASURE: warm-up complete, counters reset, measurement started\n");
+                stats_lines = 0;
+            } else if (event == MEASURE_EVENT_ENDED) {
+                printf("MEASURE: measurement window complete\n");
+                stats_lines = 0;
+                request_shutdown();
+            }
+        }
+
+        time_t current_time = time(NULL);
+        if (current_time - last_stats_time >= g_ctx.refresh_stats_seconds) {
+            if (stats_lines > 0) {
+                printf("\033[%dA\033[J", stats_lines);
+            }
+            printf("=== Client Statistics (%s UDP %s) ===", transport_name(g_ctx.transport), g_ctx.listen_ip);
+            if (measure_active()) {
+                char phase[64];
+                measure_format_phase(phase, sizeof(phase));
+                printf(" [%s]", phase);
+            }
+            printf("\n");
+            printf("Socket | Port | Sent Pkts  | Recv Pkts  | Lost     | Reordered | Total Sent  | Total Recv  | Avg RTT us\n");
+            printf("-------|------|------------|------------|----------|-----------|-------------|-------------|-----------\n");
+            stats_lines = 3;
+            for (int i = 0; i < g_ctx.num_threads; i++) {
+                client_connection_meta_t *conn = &g_ctx.client_connections[i];
+                udp_flow_t *f = &conn->udp;
+                printf("%-6d | %-4d | %-10lu | %-10lu | %-8lu | %-9lu | %-11lu | %-11lu | %.1f\n",
+                       conn->thread_index, conn->port, f->packets_sent, f->packets_received,
+                       f->packets_lost, f->packets_reordered, conn->total_bytes_sent,
+                       conn->total_bytes_received,
+                       f->packets_received ? f->rtt_sum_ns / 1000.0 / f->packets_received : 0.0);
+                stats_lines++;
+            }
+            loop_print_interval("Interval", &last_loop);
+            stats_lines++;
+            printf("\n");
+            stats_lines++;
+            last_stats_time = current_time;
+        }
+    }
+
+    udp_batch_free(&client_batch);
+    return 0;
+}
+
+void udp_print_summary(double seconds) {
+    if (g_ctx.is_server) {
+        if (!g_ctx.server_threads) {
+            return;
+        }
+        server_totals_t totals;
+        server_collect_totals(&totals);
+        uint64_t datagrams = totals.frames - g_ctx.server_baseline.frames;
+        uint64_t calls = totals.recv_calls - g_ctx.server_baseline.recv_calls;
+        printf("  %-22s %lu (%.1f/s), %.1f per recvmmsg()\n", "Datagrams echoed:", datagrams,
+               seconds > 0 ? datagrams / seconds : 0.0, calls ? (double)datagrams / calls : 0.0);
+        print_rate_line("Received:", totals.bytes_received - g_ctx.server_baseline.bytes_received, seconds);
+        print_rate_line("Sent:", totals.bytes_sent - g_ctx.server_baseline.bytes_sent, seconds);
+        printf("  %-22s %lu (send buffer full)\n", "Echoes dropped:",
+               totals.tx_drops - g_ctx.server_baseline.tx_drops);
+        printf("  %-22s batch %d, GSO %s, GRO %s\n", "UDP:", g_ctx.udp_batch,
+               g_ctx.udp_gso ? "on" : "off", g_ctx.udp_gro ? "on" : "off");
+        loop_print_summary();
+        return;
+    }
+
+    if (!g_ctx.client_connections) {
+        return;
+    }
+    uint64_t sent = 0, received = 0, lost = 0, reordered = 0, bytes_sent = 0, bytes_received = 0;
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        client_connection_meta_t *conn = &g_ctx.client_connections[i];
+        sent += conn->udp.packets_sent;
+        received += conn->udp.packets_received;
+        lost += conn->udp.packets_lost;
+        reordered += conn->udp.packets_reordered;
+        bytes_sent += conn->total_bytes_sent;
+        bytes_received += conn->total_bytes_received;
+    }
+    printf("  %-22s %lu (%.1f/s, %d bytes each)\n", "Datagrams sent:", sent,
+           seconds > 0 ? sent / seconds : 0.0, g_ctx.datagram_size);
+    printf("  %-22s %lu (%.1f/s)\n", "Datagrams received:", received, seconds > 0 ? received / seconds : 0.0);
+    print_rate_line("Sent:", bytes_sent, seconds);
+    print_rate_line("Received:", bytes_received, seconds);
+    printf("  %-22s %lu (%.3f%%), %lu reordered or late\n", "Lost:", lost,
+           sent ? 100.0 * lost / sent : 0.0, reordered);
+    printf("  %-22s batch %d, window %d, GSO %s, GRO %s\n", "UDP:", g_ctx.udp_batch, g_ctx.udp_window,
+           g_ctx.udp_gso ? "on" : "off", g_ctx.udp_gro ? "on" : "off");
+    loop_print_summary();
+    printf("  %-22s connection=%lu io=%lu system=%lu other=%lu\n", "Errors:",
+           g_ctx.errors_connection, g_ctx.errors_io, g_ctx.errors_system, g_ctx.errors_other);
+    printf("Datagram round-trip time:\n");
+    histogram_print("all sockets", &g_ctx.client_latency);
+}
@@ -82,6 +82,16 @@ void count_socket_error(int error_code) {
     }
 }
 
+uint64_t now_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t now_monotonic_ms(void) {
+    return now_monotonic_ns() / 1000000;
+}
+
 static int stats_lines = 0;
 
 void print_statistics(void) {
@@ -96,7 +106,8 @@ void print_statistics(void) {
     }
     
     printf("=== Client Statistics ===\n");
-    printf("Threads: %d | Refresh Rate: %d seconds\n\n", g_ctx.num_threads, g_ctx.refresh_stats_seconds);
+    printf("Threads: %d | Transport: %s | Refresh Rate: %d seconds\n\n", g_ctx.num_threads,
+           transport_name(g_ctx.transport), g_ctx.refresh_stats_seconds);
     
     // Error statistics
     uint64_t total_errors = g_ctx.errors_connection + g_ctx.errors_io + 
@@ -144,9 +155,148 @@ void print_statistics(void) {
     stats_lines += 1; // final newline
 }
 
+// Only async-signal-safe calls here: the first signal starts a graceful
+// drain, a second one stops the event loops immediately
 void signal_handler(int sig) {
-    printf("\nReceived signal %d, shutting down gracefully...\n", sig);
-    g_ctx.running = 0;
+    (void)sig;
+    if (g_ctx.shutdown_requested) {
+        static const char msg[] = "\nSecond signal, stopping without drain\n";
+        g_ctx.running = 0;
+        ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        (void)ignored;
+    }
+    request_shutdown();
+}
+
+int shutdown_init(void) {
+    g_ctx.shutdown_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (g_ctx.shutdown_fd == -1) {
+        perror("eventfd");
+        return -1;
+    }
+    
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGINT, &sa, NULL) == -1 || sigaction(SIGTERM, &sa, NULL) == -1) {
+        perror("sigaction");
+        return -1;
+    }
+    
+    // Peer closes during drain must surface as EPIPE, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+    return 0;
+}
+
+// Wakes every event loop: the eventfd is registered in all epoll sets and is
+// never read, so it stays readable until each loop removes it
+void request_shutdown(void) {
+    uint64_t one = 1;
+    if (!g_ctx.shutdown_requested) {
+        static const char msg[] = "\nShutdown requested, draining connections...\n";
+        g_ctx.shutdown_requested = 1;
+        ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        (void)ignored;
+    }
+    if (g_ctx.shutdown_fd > 0) {
+        ssize_t ignored = write(g_ctx.shutdown_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void print_rate_line(const char *label, uint64_t bytes, double seconds) {
+    printf("  %-22s %lu bytes (%.2f MB/s)\n", label, bytes,
+           seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0);
+}
+
+void print_final_summary(void) {
+    uint64_t end_ns = g_ctx.run_end_ns ? g_ctx.run_end_ns : now_monotonic_ns();
+    double seconds = (end_ns - g_ctx.run_start_ns) / 1e9;
+    
+    printf("\n=== Final Summary (%s, %s %s) ===\n", g_ctx.is_server ? "server" : "client",
+           transport_name(g_ctx.transport), g_ctx.listen_ip);
+    printf("  %-22s %.3f s", "Elapsed:", seconds);
+    if (g_ctx.measure.phase == MEASURE_PHASE_WARMUP) {
+        printf(" (warm-up never completed, results include it)");
+    } else if (measure_active()) {
+        printf(" (measurement window + drain, warm-up excluded)");
+    }
+    printf("\n");
+    
+    if (g_ctx.udp) {
+        udp_print_summary(seconds);
+        return;
+    }
+    
+    if (g_ctx.is_server) {
+        if (!g_ctx.server_threads) {
+            return;
+        }
+        server_totals_t totals;
+        uint64_t drained = 0, forced = 0, slab_bytes = 0;
+        int peak_slots = 0;
+        server_collect_totals(&totals);
+        uint64_t accepts = totals.accepts - g_ctx.server_baseline.accepts;
+        uint64_t received = totals.bytes_received - g_ctx.server_baseline.bytes_received;
+        uint64_t sent = totals.bytes_sent - g_ctx.server_baseline.bytes_sent;
+        for (int i = 0; i < g_ctx.num_threads; i++) {
+            drained += g_ctx.server_threads[i].drained_connections;
+            forced += g_ctx.server_threads[i].forced_connections;
+            peak_slots += g_ctx.server_threads[i].peak_slots;
+            slab_bytes += g_ctx.server_threads[i].slab_bytes;
+        }
+        printf("  %-22s %lu (%.1f/s)\n", "Connections accepted:", accepts, seconds > 0 ? accepts / seconds : 0.0);
+        printf("  %-22s %d slots used at peak, %lu KB allocated\n", "Connection state:", peak_slots, slab_bytes / 1024);
+        print_rate_line("Received:", received, seconds);
+        print_rate_line("Sent:", sent, seconds);
+        if (g_ctx.protocol->framed) {
+            uint64_t frames = totals.frames - g_ctx.server_baseline.frames;
+            printf("  %-22s %lu (%.1f/s)\n", "Requests answered:", frames, seconds > 0 ? frames / seconds : 0.0);
+        }
+        tls_print_summary();
+        printf("  %-22s %lu drained, %lu forced closed\n", "Shutdown:", drained, forced);
+        loop_print_summary();
+        sched_print_summary();
+        return;
+    }
+    
+    if (!g_ctx.client_connections) {
+        return;
+    }
+    uint64_t iterations = 0, sent = 0, received = 0, responses = 0, pool_hits = 0, cold_connects = 0;
+    for (int i = 0; i < g_ctx.num_threads; i++) {
+        client_connection_meta_t *conn = &g_ctx.client_connections[i];
+        iterations += conn->reconnect_count;
+        pool_hits += conn->pool_hits;
+        cold_connects += conn->cold_connects;
+        responses += conn->total_responses;
+        sent += conn->total_bytes_sent;
+        received += conn->total_bytes_received;
+    }
+    printf("  %-22s %lu (%.1f/s)\n", "Iterations:", iterations, seconds > 0 ? iterations / seconds : 0.0);
+    print_rate_line("Sent:", sent, seconds);
+    print_rate_line("Received:", received, seconds);
+    if (g_ctx.protocol->framed) {
+        printf("  %-22s %lu (%.1f/s, %s %u/%u bytes)\n", "Responses:", responses,
+               seconds > 0 ? responses / seconds : 0.0, g_ctx.protocol->name,
+               g_ctx.request_size, g_ctx.response_size);
+    }
+    if (g_ctx.pool_size > 0) {
+        uint64_t starts = pool_hits + cold_connects;
+        printf("  %-22s %lu from spares, %lu cold connects (%.1f%% warm)\n", "Connection pool:",
+               pool_hits, cold_connects, starts > 0 ? 100.0 * pool_hits / starts : 0.0);
+    }
+    trace_print_summary();
+    printf("  %-22s connection=%lu io=%lu system=%lu other=%lu\n", "Errors:",
+           g_ctx.errors_connection, g_ctx.errors_io, g_ctx.errors_system, g_ctx.errors_other);
+    tls_print_summary();
+    loop_print_summary();
+    printf("Iteration latency (connect to full echo):\n");
+    histogram_print("all connections", &g_ctx.client_latency);
+    if (g_ctx.tls_enabled) {
+        histogram_print("TLS handshake", &g_ctx.client_handshake_latency);
+    }
 }
 
 void cleanup_resources(void) {
@@ -157,15 +307,27 @@ void cleanup_resources(void) {
     if (!g_ctx.is_server) {
         if (g_ctx.client_connections) {
             for (int i = 0; i < g_ctx.num_threads; i++) {
-                if (g_ctx.client_connections[i].socket_fd != -1) {
-                    close(g_ctx.client_connections[i].socket_fd);
+                client_connection_meta_t *conn = &g_ctx.client_connections[i];
+                if (conn->socket_fd != -1) {
+                    close(conn->socket_fd);
+                }
+                for (int j = 0; j < conn->pool_count; j++) {
+                    close(conn->pool_fds[(conn->pool_head + j) % g_ctx.pool_size]);
                 }
             }
             free(g_ctx.client_connections);
         }
+        free(g_ctx.client_pool_fds);
         
         if (g_ctx.client_epoll_fd != -1) {
             close(g_ctx.client_epoll_fd);
         }
     }
+    
+    if (g_ctx.shutdown_fd > 0) {
+        close(g_ctx.shutdown_fd);
+    }
+    
+    trace_replay_close();
+    tls_cleanup();
 } 
\ No newline at end of file